@@ -0,0 +1,184 @@
+/**
+ * @file safety_bench.cpp
+ * @brief On-brain micro-benchmarks for the checks in safety.h.
+ * @author Adam Salem
+ * @copyright Copyright (c) 2024 Adam Salem
+ *
+ * Copy this file into the `src` folder of a PROS 4 project in place of `main.cpp`, put `safety.h` in `include`,
+ * then upload and open the terminal with `pros terminal`. Every helper is timed over thousands of iterations for a
+ * 6-motor, an 8-motor, and a full 21-port configuration, and the results are printed as nanoseconds per call and
+ * heap bytes allocated per call. The numbers depend on what is plugged in, so keep the robot the same between runs
+ * you want to compare.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "api.h"
+#include "safety.h"
+
+namespace
+{
+    /**
+     * The number of times each benchmark body runs.
+     */
+    constexpr int ITERATIONS = 2000;
+
+    std::atomic<std::size_t> allocated_bytes{0};
+
+    /**
+     * Keeps benchmark results alive so the compiler cannot drop the calls that produce them.
+     */
+    volatile std::uintptr_t sink = 0;
+
+    /**
+     * Runs a benchmark body and prints its cost per call.
+     *
+     * @param name The name printed for the benchmark.
+     * @param body The code to measure. It is called `ITERATIONS` times.
+     */
+    template <typename Body>
+    void bench(const char *name, Body &&body)
+    {
+        body();
+        std::size_t heap_before = allocated_bytes.load(std::memory_order_relaxed);
+        std::uint64_t start = pros::micros();
+        for (int i = 0; i < ITERATIONS; i++)
+            body();
+        std::uint64_t elapsed_us = pros::micros() - start;
+        std::size_t heap_bytes = allocated_bytes.load(std::memory_order_relaxed) - heap_before;
+
+        std::printf("%-40s %10.0f ns/call %8.1f B/call\n", name, elapsed_us * 1000.0 / ITERATIONS,
+                    static_cast<double>(heap_bytes) / ITERATIONS);
+    }
+
+    /**
+     * Benchmarks every helper against one robot configuration.
+     *
+     * @param label The name of the configuration.
+     * @param ports The smart ports used by the configuration, all treated as motors.
+     */
+    void benchConfig(const char *label, std::initializer_list<std::int8_t> ports)
+    {
+        std::printf("\n== %s (%u ports) ==\n", label, static_cast<unsigned>(ports.size()));
+
+        pros::v5::MotorGroup group(ports);
+        std::vector<pros::v5::Device> devices;
+        safety::Manifest manifest;
+        for (std::int8_t port : ports)
+        {
+            devices.emplace_back(port);
+            manifest.expect(port, pros::v5::DeviceType::motor);
+        }
+        safety::PortSnapshot snapshot = safety::PortSnapshot::capture();
+        safety::PortMask expected = safety::portsOf(devices);
+        safety::PortList list;
+        safety::ManifestDiff diff;
+        char text[safety::DEVICE_TEXT_CAPACITY];
+
+        bench("isPluggedIn (every port)", [&]
+              {
+                  for (std::int8_t port : ports)
+                      sink = sink + safety::isPluggedIn(port);
+              });
+        bench("isMotor (every port)", [&]
+              {
+                  for (std::int8_t port : ports)
+                      sink = sink + safety::isMotor(port);
+              });
+        bench("isMotor snapshot (every port)", [&]
+              {
+                  for (std::int8_t port : ports)
+                      sink = sink + safety::isMotor(snapshot, port);
+              });
+        bench("checkMotorGroup -> vector", [&]
+              { sink = sink + safety::checkMotorGroup(group).size(); });
+        bench("checkMotorGroup -> PortList", [&]
+              { sink = sink + safety::checkMotorGroup(group, list); });
+        bench("checkMotorGroup snapshot -> PortList", [&]
+              { sink = sink + safety::checkMotorGroup(snapshot, group, list); });
+        bench("inspectMotorGroup", [&]
+              { sink = sink + safety::inspectMotorGroup(group).bad().bits(); });
+        bench("inspectMotorGroup snapshot", [&]
+              { sink = sink + safety::inspectMotorGroup(snapshot, group).bad().bits(); });
+        bench("checkMotorGroupMask snapshot", [&]
+              { sink = sink + safety::checkMotorGroupMask(snapshot, group).bits(); });
+        bench("checkDevices -> vector", [&]
+              { sink = sink + safety::checkDevices(devices).size(); });
+        bench("checkDevices -> PortList", [&]
+              { sink = sink + safety::checkDevices(devices, list); });
+        bench("checkDevicesMask snapshot", [&]
+              { sink = sink + safety::checkDevicesMask(snapshot, devices).bits(); });
+        bench("checkPorts snapshot (mask only)", [&]
+              { sink = sink + safety::checkPorts(snapshot, expected).bits(); });
+        bench("Manifest::diff snapshot", [&]
+              {
+                  manifest.diff(snapshot, diff);
+                  sink = sink + diff.missing.bits();
+              });
+        bench("format_devices", [&]
+              { sink = sink + safety::format_devices(text, devices); });
+        bench("format_devices snapshot", [&]
+              { sink = sink + safety::format_devices(text, snapshot, devices); });
+        bench("print_unplugged_devices", [&]
+              { sink = sink + reinterpret_cast<std::uintptr_t>(safety::print_unplugged_devices(devices)); });
+    }
+} // namespace
+
+void *operator new(std::size_t size)
+{
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    void *memory = std::malloc(size ? size : 1);
+    if (!memory)
+        std::abort();
+    return memory;
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void initialize()
+{
+    pros::delay(500);
+    std::printf("safety_bench: %d iterations per benchmark\n", ITERATIONS);
+
+    safety::PortSnapshot snapshot;
+    bench("PortSnapshot::refresh (21 ports)", [&]
+          {
+              snapshot.refresh();
+              sink = sink + snapshot.timestamp();
+          });
+
+    benchConfig("6-motor drive", {1, 2, 3, 4, 5, 6});
+    benchConfig("8-motor drive", {1, 2, 3, 4, 5, 6, 7, 8});
+    benchConfig("full load", {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21});
+
+    std::printf("\nsafety_bench: done\n");
+}
+
+void disabled()
+{
+}
+
+void competition_initialize()
+{
+}
+
+void autonomous()
+{
+}
+
+void opcontrol()
+{
+    while (true)
+        pros::delay(20);
+}
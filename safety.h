@@ -7,200 +7,6143 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <iterator>
+#include <optional>
+#include <span>
+
+#ifdef SAFETY_SIM
+#include "sim/pros_sim.h"
+#else
 #include "api.h"
+#endif
 
 namespace safety
 {
     /**
-     * Checks if a device is plugged in at the given port.
+     * The number of smart ports on the V5 brain.
+     */
+    inline constexpr int SMART_PORT_COUNT = 21;
+
+#ifdef SAFETY_INSTRUMENT
+    /**
+     * The checks that the instrumentation build counts and times.
+     */
+    enum class CheckId : std::uint8_t
+    {
+        isPluggedIn,       ///< `isPluggedIn` with a direct port read.
+        typeCheck,         ///< `is`, `isAnyOf`, and the named predicates with a direct port read.
+        checkMotorGroup,   ///< Every `checkMotorGroup` overload that reads ports itself.
+        inspectMotorGroup, ///< `inspectMotorGroup` with direct port reads.
+        checkDevices,      ///< Every `checkDevices` overload that reads ports itself.
+        imuStatus,         ///< `imuStatus` with a direct port read.
+        snapshotRefresh,   ///< `PortSnapshot::refresh`.
+        manifestDiff,      ///< `Manifest::diff`.
+        formatDevices,     ///< `format_devices` and `format_unplugged_devices`.
+        watchdogSample,    ///< `Watchdog::sample`.
+        count              ///< The number of checks, not a check itself.
+    };
+
+    /**
+     * The call count and latency of one check.
+     */
+    struct CheckStats
+    {
+        std::uint32_t calls = 0;    ///< The number of completed calls.
+        std::uint32_t min_us = 0;   ///< The fastest call in microseconds.
+        std::uint32_t max_us = 0;   ///< The slowest call in microseconds.
+        std::uint64_t total_us = 0; ///< The total time of every call in microseconds.
+
+        /**
+         * Gets the average latency of the check.
+         *
+         * @return The mean time per call in microseconds, or 0 if there were no calls.
+         *
+         * @throws None
+         */
+        double mean_us() const
+        {
+            return calls == 0 ? 0.0 : static_cast<double>(total_us) / calls;
+        }
+    };
+
+    /**
+     * A copy of every instrumentation counter at one point in time.
+     */
+    struct InstrumentationSnapshot
+    {
+        std::array<CheckStats, static_cast<std::size_t>(CheckId::count)> checks{}; ///< The stats of each check.
+        std::uint32_t plugged_type_reads = 0; ///< The number of `get_plugged_type` kernel calls.
+
+        const CheckStats &operator[](CheckId id) const
+        {
+            return checks[static_cast<std::size_t>(id)];
+        }
+    };
+
+    /**
+     * The shared counters behind `instrumentation()`. Counters are updated with relaxed atomics, so they are
+     * safe to update from every task, but a snapshot taken while checks run may mix values from adjacent calls.
+     */
+    struct InstrumentationCounters
+    {
+        struct Counter
+        {
+            std::atomic<std::uint32_t> calls{0};
+            std::atomic<std::uint32_t> min_us{UINT32_MAX};
+            std::atomic<std::uint32_t> max_us{0};
+            std::atomic<std::uint64_t> total_us{0};
+        };
+
+        std::array<Counter, static_cast<std::size_t>(CheckId::count)> checks;
+        std::atomic<std::uint32_t> plugged_type_reads{0};
+
+        static InstrumentationCounters &get()
+        {
+            static InstrumentationCounters counters;
+            return counters;
+        }
+
+        void record(CheckId id, std::uint32_t elapsed_us)
+        {
+            Counter &counter = checks[static_cast<std::size_t>(id)];
+            counter.calls.fetch_add(1, std::memory_order_relaxed);
+            counter.total_us.fetch_add(elapsed_us, std::memory_order_relaxed);
+            std::uint32_t seen = counter.min_us.load(std::memory_order_relaxed);
+            while (elapsed_us < seen && !counter.min_us.compare_exchange_weak(seen, elapsed_us, std::memory_order_relaxed))
+            {
+            }
+            seen = counter.max_us.load(std::memory_order_relaxed);
+            while (elapsed_us > seen && !counter.max_us.compare_exchange_weak(seen, elapsed_us, std::memory_order_relaxed))
+            {
+            }
+        }
+    };
+
+    /**
+     * Times the enclosing scope with `pros::micros()` and records it against a check.
+     */
+    class ScopedCheckTimer
+    {
+    public:
+        explicit ScopedCheckTimer(CheckId id) : id_(id), start_(pros::micros())
+        {
+        }
+
+        ScopedCheckTimer(const ScopedCheckTimer &) = delete;
+        ScopedCheckTimer &operator=(const ScopedCheckTimer &) = delete;
+
+        ~ScopedCheckTimer()
+        {
+            InstrumentationCounters::get().record(id_, static_cast<std::uint32_t>(pros::micros() - start_));
+        }
+
+    private:
+        CheckId id_;
+        std::uint64_t start_;
+    };
+
+    /**
+     * Copies every instrumentation counter.
      *
-     * @param port The port number of the device.
+     * @return The call counts and latencies recorded since start-up or the last `resetInstrumentation`.
      *
-     * @return True if the device is plugged in and its type is not none or undefined, false otherwise.
+     * @throws None
      */
-    bool isPluggedIn(int port)
+    inline InstrumentationSnapshot instrumentation()
     {
-        return !(
-            (pros::v5::Device::get_plugged_type(port) == pros::v5::DeviceType::none) ||
-            (pros::v5::Device::get_plugged_type(port) == pros::v5::DeviceType::undefined));
+        InstrumentationCounters &counters = InstrumentationCounters::get();
+        InstrumentationSnapshot snapshot;
+        for (std::size_t i = 0; i < snapshot.checks.size(); i++)
+        {
+            CheckStats &stats = snapshot.checks[i];
+            stats.calls = counters.checks[i].calls.load(std::memory_order_relaxed);
+            stats.min_us = stats.calls == 0 ? 0 : counters.checks[i].min_us.load(std::memory_order_relaxed);
+            stats.max_us = counters.checks[i].max_us.load(std::memory_order_relaxed);
+            stats.total_us = counters.checks[i].total_us.load(std::memory_order_relaxed);
+        }
+        snapshot.plugged_type_reads = counters.plugged_type_reads.load(std::memory_order_relaxed);
+        return snapshot;
     }
 
     /**
-     * Checks if a device is a motor at the given port.
+     * Clears every instrumentation counter.
      *
-     * @param port The port number of the device.
+     * @throws None
+     */
+    inline void resetInstrumentation()
+    {
+        InstrumentationCounters &counters = InstrumentationCounters::get();
+        for (InstrumentationCounters::Counter &counter : counters.checks)
+        {
+            counter.calls.store(0, std::memory_order_relaxed);
+            counter.min_us.store(UINT32_MAX, std::memory_order_relaxed);
+            counter.max_us.store(0, std::memory_order_relaxed);
+            counter.total_us.store(0, std::memory_order_relaxed);
+        }
+        counters.plugged_type_reads.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * Converts a CheckId to the name of the check it counts.
      *
-     * @return True if the device is a motor, false otherwise.
+     * @param id The check.
+     *
+     * @return The name of the check, such as "checkMotorGroup".
      *
      * @throws None
      */
-    bool isMotor(int port)
+    constexpr const char *checkId_to_string(CheckId id)
     {
-        return pros::v5::Device::get_plugged_type(port) == pros::v5::DeviceType::motor;
+        constexpr const char *names[] = {"isPluggedIn",  "typeCheck",       "checkMotorGroup", "inspectMotorGroup",
+                                         "checkDevices", "imuStatus",       "snapshotRefresh", "manifestDiff",
+                                         "formatDevices", "watchdogSample"};
+        std::size_t index = static_cast<std::size_t>(id);
+        return index < std::size(names) ? names[index] : "unknown";
     }
 
+/**
+ * Times the enclosing scope against a `safety::CheckId` in instrumentation builds.
+ */
+#define SAFETY_PROFILE(id) ::safety::ScopedCheckTimer safety_profile_timer_(::safety::CheckId::id)
+#else
+#define SAFETY_PROFILE(id) ((void)0)
+#endif
+
     /**
-     * Checks if a device is an IMU at the given port.
+     * Reads the device type plugged into a port from the kernel. Every port read in this header goes through
+     * this function, so the instrumentation build can count them.
      *
      * @param port The port number of the device.
      *
-     * @return True if the device is an IMU, false otherwise.
+     * @return The device type reported by `pros::v5::Device::get_plugged_type`.
      *
      * @throws None
      */
-    bool isImu(int port)
+    inline pros::v5::DeviceType readPluggedType(int port)
     {
-        return pros::v5::Device::get_plugged_type(port) == pros::v5::DeviceType::imu;
+#ifdef SAFETY_INSTRUMENT
+        InstrumentationCounters::get().plugged_type_reads.fetch_add(1, std::memory_order_relaxed);
+#endif
+        return pros::v5::Device::get_plugged_type(port);
     }
 
     /**
-     * Checks if a device is a radio at the given port.
+     * A set of smart ports stored as one bit per port in a 32-bit word.
+     *
+     * Bit 0 is port 1 and bit 20 is port 21. Set operations, counting, and membership tests are single ALU
+     * operations, and iterating the mask visits the set ports in ascending order.
+     */
+    class PortMask
+    {
+    public:
+        /**
+         * The bits that correspond to real smart ports.
+         */
+        static constexpr std::uint32_t ALL_BITS = (std::uint32_t(1) << SMART_PORT_COUNT) - 1;
+
+        /**
+         * Visits the ports of a mask in ascending order.
+         */
+        class iterator
+        {
+        public:
+            constexpr explicit iterator(std::uint32_t bits) : bits_(bits)
+            {
+            }
+
+            constexpr int operator*() const
+            {
+                return std::countr_zero(bits_) + 1;
+            }
+
+            constexpr iterator &operator++()
+            {
+                bits_ &= bits_ - 1;
+                return *this;
+            }
+
+            constexpr bool operator==(const iterator &other) const = default;
+
+        private:
+            std::uint32_t bits_;
+        };
+
+        /**
+         * Creates an empty mask.
+         */
+        constexpr PortMask() = default;
+
+        /**
+         * Creates a mask from raw bits. Bits above port 21 are discarded.
+         *
+         * @param bits The raw bits, with bit 0 for port 1.
+         */
+        constexpr explicit PortMask(std::uint32_t bits) : bits_(bits & ALL_BITS)
+        {
+        }
+
+        /**
+         * Creates a mask holding the given ports. Reversed (negative) motor ports are accepted and out of range
+         * ports are ignored.
+         *
+         * @param ports The port numbers to add.
+         */
+        constexpr PortMask(std::initializer_list<int> ports)
+        {
+            for (int port : ports)
+                set(port);
+        }
+
+        /**
+         * Creates a mask holding every smart port.
+         *
+         * @return The full mask.
+         *
+         * @throws None
+         */
+        static constexpr PortMask all()
+        {
+            return PortMask(ALL_BITS);
+        }
+
+        /**
+         * Checks if the mask holds the given port.
+         *
+         * @param port The port number to check. Reversed (negative) motor ports are accepted.
+         *
+         * @return True if the port is in the mask, false otherwise or if the port is out of range.
+         *
+         * @throws None
+         */
+        constexpr bool test(int port) const
+        {
+            return (bits_ & bit(port)) != 0;
+        }
+
+        /**
+         * Adds a port to the mask. Out of range ports are ignored.
+         *
+         * @param port The port number to add. Reversed (negative) motor ports are accepted.
+         *
+         * @return This mask.
+         *
+         * @throws None
+         */
+        constexpr PortMask &set(int port)
+        {
+            bits_ |= bit(port);
+            return *this;
+        }
+
+        /**
+         * Removes a port from the mask.
+         *
+         * @param port The port number to remove. Reversed (negative) motor ports are accepted.
+         *
+         * @return This mask.
+         *
+         * @throws None
+         */
+        constexpr PortMask &reset(int port)
+        {
+            bits_ &= ~bit(port);
+            return *this;
+        }
+
+        /**
+         * Gets the number of ports in the mask.
+         *
+         * @return The population count of the mask.
+         *
+         * @throws None
+         */
+        constexpr int count() const
+        {
+            return std::popcount(bits_);
+        }
+
+        /**
+         * Checks if the mask holds no ports.
+         *
+         * @return True if the mask is empty, false otherwise.
+         *
+         * @throws None
+         */
+        constexpr bool empty() const
+        {
+            return bits_ == 0;
+        }
+
+        /**
+         * Checks if the mask holds at least one port.
+         *
+         * @return True if the mask is not empty, false otherwise.
+         *
+         * @throws None
+         */
+        constexpr bool any() const
+        {
+            return bits_ != 0;
+        }
+
+        /**
+         * Gets the raw bits of the mask.
+         *
+         * @return The bits, with bit 0 for port 1.
+         *
+         * @throws None
+         */
+        constexpr std::uint32_t bits() const
+        {
+            return bits_;
+        }
+
+        constexpr iterator begin() const
+        {
+            return iterator(bits_);
+        }
+
+        constexpr iterator end() const
+        {
+            return iterator(0);
+        }
+
+        constexpr PortMask operator&(PortMask other) const
+        {
+            return PortMask(bits_ & other.bits_);
+        }
+
+        constexpr PortMask operator|(PortMask other) const
+        {
+            return PortMask(bits_ | other.bits_);
+        }
+
+        constexpr PortMask operator^(PortMask other) const
+        {
+            return PortMask(bits_ ^ other.bits_);
+        }
+
+        constexpr PortMask operator~() const
+        {
+            return PortMask(~bits_);
+        }
+
+        constexpr PortMask &operator&=(PortMask other)
+        {
+            bits_ &= other.bits_;
+            return *this;
+        }
+
+        constexpr PortMask &operator|=(PortMask other)
+        {
+            bits_ |= other.bits_;
+            return *this;
+        }
+
+        constexpr PortMask &operator^=(PortMask other)
+        {
+            bits_ ^= other.bits_;
+            return *this;
+        }
+
+        constexpr bool operator==(const PortMask &other) const = default;
+
+    private:
+        static constexpr std::uint32_t bit(int port)
+        {
+            if (port < 0)
+                port = -port;
+            if (port < 1 || port > SMART_PORT_COUNT)
+                return 0;
+            return std::uint32_t(1) << (port - 1);
+        }
+
+        std::uint32_t bits_ = 0;
+    };
+
+    /**
+     * A copy of the device type plugged into every smart port, read in a single pass.
+     *
+     * Refreshing the snapshot costs one `get_plugged_type` call per smart port. After that, every lookup is
+     * an array read, so checking the same port from several helpers does not touch the kernel again.
+     */
+    class PortSnapshot
+    {
+    public:
+        /**
+         * Creates a snapshot that reports every port as `pros::v5::DeviceType::none` until it is refreshed.
+         */
+        PortSnapshot()
+        {
+            types_.fill(static_cast<std::uint8_t>(pros::v5::DeviceType::none));
+        }
+
+        /**
+         * Creates a snapshot filled from the current state of every smart port.
+         *
+         * @return The freshly read snapshot.
+         *
+         * @throws None
+         */
+        static PortSnapshot capture()
+        {
+            PortSnapshot snapshot;
+            snapshot.refresh();
+            return snapshot;
+        }
+
+        /**
+         * Reads the device type of every smart port into the snapshot.
+         *
+         * @throws None
+         */
+        void refresh()
+        {
+            SAFETY_PROFILE(snapshotRefresh);
+            for (int port = 1; port <= SMART_PORT_COUNT; port++)
+                types_[port - 1] = static_cast<std::uint8_t>(readPluggedType(port));
+            time_ = pros::millis();
+        }
+
+        /**
+         * Reads the device type of some smart ports into the snapshot. The other ports keep their earlier values,
+         * and the timestamp becomes the time of this partial refresh.
+         *
+         * @param ports The ports to read.
+         *
+         * @throws None
+         */
+        void refresh(PortMask ports)
+        {
+            SAFETY_PROFILE(snapshotRefresh);
+            for (int port : ports)
+                types_[port - 1] = static_cast<std::uint8_t>(readPluggedType(port));
+            time_ = pros::millis();
+        }
+
+        /**
+         * Gets the device type that was plugged into the given port when the snapshot was refreshed.
+         *
+         * @param port The port number of the device.
+         *
+         * @return The recorded device type, or `pros::v5::DeviceType::undefined` if the port is out of range.
+         *
+         * @throws None
+         */
+        pros::v5::DeviceType type(int port) const
+        {
+            if (port < 1 || port > SMART_PORT_COUNT)
+                return pros::v5::DeviceType::undefined;
+            return static_cast<pros::v5::DeviceType>(types_[port - 1]);
+        }
+
+        /**
+         * Gets the time the snapshot was last refreshed.
+         *
+         * @return The value of `pros::millis()` at the last refresh, or 0 if it was never refreshed.
+         *
+         * @throws None
+         */
+        std::uint32_t timestamp() const
+        {
+            return time_;
+        }
+
+        /**
+         * Gets the ports that had a device plugged in when the snapshot was refreshed.
+         *
+         * @return A mask of every port whose type was not none or undefined.
+         *
+         * @throws None
+         */
+        PortMask plugged() const
+        {
+            PortMask mask;
+            for (int port = 1; port <= SMART_PORT_COUNT; port++)
+            {
+                pros::v5::DeviceType recorded = type(port);
+                if (!(recorded == pros::v5::DeviceType::none || recorded == pros::v5::DeviceType::undefined))
+                    mask.set(port);
+            }
+            return mask;
+        }
+
+        /**
+         * Gets the ports that held the given device type when the snapshot was refreshed.
+         *
+         * @param wanted The device type to look for.
+         *
+         * @return A mask of every port whose type was `wanted`.
+         *
+         * @throws None
+         */
+        PortMask ofType(pros::v5::DeviceType wanted) const
+        {
+            PortMask mask;
+            for (int port = 1; port <= SMART_PORT_COUNT; port++)
+            {
+                if (type(port) == wanted)
+                    mask.set(port);
+            }
+            return mask;
+        }
+
+    private:
+        friend class SharedSnapshot;
+
+        std::array<std::uint8_t, SMART_PORT_COUNT> types_;
+        std::uint32_t time_ = 0;
+    };
+
+    /**
+     * A fixed-capacity list of port numbers that lives on the stack.
+     *
+     * Holds at most one entry per smart port, so the allocation-free check overloads can report their results
+     * without touching the heap.
+     */
+    class PortList
+    {
+    public:
+        /**
+         * Adds a port to the end of the list.
+         *
+         * @param port The port number to add.
+         *
+         * @return True if the port was added, false if the list was full.
+         *
+         * @throws None
+         */
+        bool push(int port)
+        {
+            if (count_ == SMART_PORT_COUNT)
+                return false;
+            ports_[count_++] = static_cast<std::uint8_t>(port);
+            return true;
+        }
+
+        /**
+         * Removes every port from the list.
+         *
+         * @throws None
+         */
+        void clear()
+        {
+            count_ = 0;
+        }
+
+        /**
+         * Gets the number of ports in the list.
+         *
+         * @return The number of ports.
+         *
+         * @throws None
+         */
+        std::size_t size() const
+        {
+            return count_;
+        }
+
+        /**
+         * Checks if the list has no ports.
+         *
+         * @return True if the list is empty, false otherwise.
+         *
+         * @throws None
+         */
+        bool empty() const
+        {
+            return count_ == 0;
+        }
+
+        /**
+         * Gets the port at the given position.
+         *
+         * @param index The position in the list. Must be less than `size()`.
+         *
+         * @return The port number.
+         *
+         * @throws None
+         */
+        std::uint8_t operator[](std::size_t index) const
+        {
+            return ports_[index];
+        }
+
+        const std::uint8_t *begin() const
+        {
+            return ports_.data();
+        }
+
+        const std::uint8_t *end() const
+        {
+            return ports_.data() + count_;
+        }
+
+    private:
+        std::array<std::uint8_t, SMART_PORT_COUNT> ports_{};
+        std::uint8_t count_ = 0;
+    };
+
+    /**
+     * Checks if a device is plugged in at the given port.
      *
      * @param port The port number of the device.
      *
-     * @return True if the device is a radio, false otherwise.
+     * @return True if the device is plugged in and its type is not none or undefined, false otherwise.
+     */
+    inline bool isPluggedIn(int port)
+    {
+        SAFETY_PROFILE(isPluggedIn);
+        pros::v5::DeviceType type = readPluggedType(port);
+        return !(type == pros::v5::DeviceType::none || type == pros::v5::DeviceType::undefined);
+    }
+
+    /**
+     * Checks if a device was plugged in at the given port when the snapshot was refreshed.
+     *
+     * @param snapshot The snapshot to read from.
+     * @param port The port number of the device.
+     *
+     * @return True if the recorded type is not none or undefined, false otherwise.
      *
      * @throws None
      */
-    bool isRadio(int port)
+    inline bool isPluggedIn(const PortSnapshot &snapshot, int port)
     {
-        return pros::v5::Device::get_plugged_type(port) == pros::v5::DeviceType::radio;
+        pros::v5::DeviceType type = snapshot.type(port);
+        return !(type == pros::v5::DeviceType::none || type == pros::v5::DeviceType::undefined);
     }
 
     /**
-     * Checks if a device is a rotation sensor at the given port.
+     * Checks which of the expected ports were unplugged when the snapshot was refreshed.
      *
-     * @param port The port number of the device.
+     * @param snapshot The snapshot to read from.
+     * @param expected The ports that should have a device plugged in.
      *
-     * @return True if the device is a rotation sensor, false otherwise.
+     * @return A mask of the expected ports that are unplugged.
      *
      * @throws None
      */
-    bool isRotation(int port)
+    inline PortMask checkPorts(const PortSnapshot &snapshot, PortMask expected)
     {
-        return pros::v5::Device::get_plugged_type(port) == pros::v5::DeviceType::rotation;
+        return expected & ~snapshot.plugged();
     }
 
     /**
-     * Checks the given MotorGroup for any ports that are not motors or are not plugged in.
+     * Checks which of the expected ports did not hold the given device type when the snapshot was refreshed.
      *
-     * @param group The MotorGroup to check.
+     * @param snapshot The snapshot to read from.
+     * @param expected The ports that should hold a device of type `type`.
+     * @param type The device type the ports should hold.
      *
-     * @return A vector of ports that are not motors or are not plugged in.
+     * @return A mask of the expected ports that are unplugged or hold a different type.
      *
      * @throws None
      */
-    std::vector<int> checkMotorGroup(pros::v5::MotorGroup &group)
+    inline PortMask checkPorts(const PortSnapshot &snapshot, PortMask expected, pros::v5::DeviceType type)
     {
-        std::vector<int> ports;
-        for (int port : group.get_port_all())
-        {
-            if (!isMotor(port))
-                ports.push_back(port);
-            if (isPluggedIn(port))
-                ports.push_back(port);
-        }
-        return ports;
+        return expected & ~snapshot.ofType(type);
     }
 
     /**
-     * Checks if a device at the given port is an IMU and it is plugged in.
+     * Checks if the device at the given port is of a given type.
+     *
+     * @tparam Type The device type to check for.
      *
      * @param port The port number of the device.
      *
-     * @return True if the device is an IMU and is plugged in, false otherwise.
+     * @return True if the device is of type `Type`, false otherwise.
      *
      * @throws None
      */
-    bool checkImu(int port)
+    template <pros::v5::DeviceType Type>
+    inline bool is(int port)
     {
-        return pros::v5::Device::get_plugged_type(port) == pros::v5::DeviceType::imu && isPluggedIn(port);
+        SAFETY_PROFILE(typeCheck);
+        return readPluggedType(port) == Type;
     }
 
     /**
-     * A function that checks a list of devices for being unplugged and returns a vector of ports that are unplugged.
+     * Checks if the snapshot recorded a device of a given type at the given port.
      *
-     * @param devices The vector of devices to check.
+     * @tparam Type The device type to check for.
      *
-     * @return A vector of ports that are unplugged.
+     * @param snapshot The snapshot to read from.
+     * @param port The port number of the device.
+     *
+     * @return True if the recorded device is of type `Type`, false otherwise.
      *
      * @throws None
      */
-    std::vector<int> checkDevices(std::vector<pros::v5::Device> devices)
+    template <pros::v5::DeviceType Type>
+    inline bool is(const PortSnapshot &snapshot, int port)
     {
-        std::vector<int> ports;
-        for (pros::v5::Device device : devices)
-        {
-            if (!isPluggedIn(device.get_port()))
-                ports.push_back(device.get_port());
-        }
-        return ports;
+        return snapshot.type(port) == Type;
     }
 
     /**
-     * @brief Converts a `pros::v5::DeviceType` enum value to its corresponding string representation.
+     * Checks if the device at the given port is any of the given types, with a single type read.
      *
-     * @param type The `pros::v5::DeviceType` enum value to convert.
+     * @tparam Types The device types to check for.
      *
-     * @return A string representation of the `pros::v5::DeviceType` enum value. Returns "none" for `pros::v5::DeviceType::none`, "undefined" for `pros::v5::DeviceType::undefined`, "motor" for `pros::v5::DeviceType::motor`, "rotation" for `pros::v5::DeviceType::rotation`, "imu" for `pros::v5::DeviceType::imu`, "radio" for `pros::v5::DeviceType::radio`, "distance" for `pros::v5::DeviceType::distance`, "vision" for `pros::v5::DeviceType::vision`, "adi" for `pros::v5::DeviceType::adi`, "optical" for `pros::v5::DeviceType::optical`, "gps" for `pros::v5::DeviceType::gps`, "serial" for `pros::v5::DeviceType::serial`, and "unknown" for any other value.
+     * @param port The port number of the device.
+     *
+     * @return True if the device is one of `Types`, false otherwise.
      *
      * @throws None
      */
-    const char *deviceType_to_string(pros::v5::DeviceType type)
+    template <pros::v5::DeviceType... Types>
+    inline bool isAnyOf(int port)
     {
-        // Maps `pros::v5::DeviceType` enum values to their corresponding string representations.
-        // Returns "none" for `pros::v5::DeviceType::none`, "undefined" for `pros::v5::DeviceType::undefined`, "motor" for `pros::v5::DeviceType::motor`, "rotation" for `pros::v5::DeviceType::rotation`, "imu" for `pros::v5::DeviceType::imu`, "radio" for `pros::v5::DeviceType::radio`, "distance" for `pros::v5::DeviceType::distance`, "vision" for `pros::v5::DeviceType::vision`, "adi" for `pros::v5::DeviceType::adi`, "optical" for `pros::v5::DeviceType::optical`, "gps" for `pros::v5::DeviceType::gps`, "serial" for `pros::v5::DeviceType::serial`, and "unknown" for any other value.
-        switch (type)
-        {
-        case pros::v5::DeviceType::none:
-            return "none";
-        case pros::v5::DeviceType::undefined:
-            return "undefined";
-        case pros::v5::DeviceType::motor:
-            return "motor";
-        case pros::v5::DeviceType::rotation:
-            return "rotation";
-        case pros::v5::DeviceType::imu:
-            return "imu";
-        case pros::v5::DeviceType::radio:
-            return "radio";
-        case pros::v5::DeviceType::distance:
-            return "distance";
-        case pros::v5::DeviceType::vision:
-            return "vision";
-        case pros::v5::DeviceType::adi:
-            return "adi";
-        case pros::v5::DeviceType::optical:
-            return "optical";
-        case pros::v5::DeviceType::gps:
-            return "gps";
-        case pros::v5::DeviceType::serial:
-            return "serial";
-        default:
-            return "unknown";
-        }
+        SAFETY_PROFILE(typeCheck);
+        static_assert(sizeof...(Types) > 0, "isAnyOf needs at least one device type");
+        pros::v5::DeviceType type = readPluggedType(port);
+        return ((type == Types) || ...);
     }
 
     /**
-     * A function that generates a string of plugged-in devices with their types and ports.
+     * Checks if the snapshot recorded a device of any of the given types at the given port.
      *
-     * @param devices The vector of devices to check for being plugged in.
+     * @tparam Types The device types to check for.
      *
-     * @return A C-style string of plugged-in devices with their types and ports.
+     * @param snapshot The snapshot to read from.
+     * @param port The port number of the device.
+     *
+     * @return True if the recorded device is one of `Types`, false otherwise.
      *
      * @throws None
      */
-    const char *print_unplugged_devices(std::vector<pros::v5::Device> devices)
+    template <pros::v5::DeviceType... Types>
+    inline bool isAnyOf(const PortSnapshot &snapshot, int port)
     {
-        std::string output;
-        for (pros::v5::Device device : devices)
-        {
-            if (isPluggedIn(device.get_port()))
-                output +=
-                    std::string(deviceType_to_string(pros::v5::Device::get_plugged_type(device.get_port()))) + ": " + std::to_string(device.get_port()) + ",\n";
-        }
-        return output.c_str();
+        static_assert(sizeof...(Types) > 0, "isAnyOf needs at least one device type");
+        pros::v5::DeviceType type = snapshot.type(port);
+        return ((type == Types) || ...);
     }
+
+    /**
+     * Checks if a device is a motor at the given port.
+     *
+     * @param port The port number of the device.
+     *
+     * @return True if the device is a motor, false otherwise.
+     *
+     * @throws None
+     */
+    inline bool isMotor(int port)
+    {
+        return is<pros::v5::DeviceType::motor>(port);
+    }
+
+    /**
+     * Checks if the snapshot recorded a motor at the given port.
+     *
+     * @param snapshot The snapshot to read from.
+     * @param port The port number of the device.
+     *
+     * @return True if the recorded device is a motor, false otherwise.
+     *
+     * @throws None
+     */
+    inline bool isMotor(const PortSnapshot &snapshot, int port)
+    {
+        return is<pros::v5::DeviceType::motor>(snapshot, port);
+    }
+
+    /**
+     * Checks if a device is an IMU at the given port.
+     *
+     * @param port The port number of the device.
+     *
+     * @return True if the device is an IMU, false otherwise.
+     *
+     * @throws None
+     */
+    inline bool isImu(int port)
+    {
+        return is<pros::v5::DeviceType::imu>(port);
+    }
+
+    /**
+     * Checks if the snapshot recorded an IMU at the given port.
+     *
+     * @param snapshot The snapshot to read from.
+     * @param port The port number of the device.
+     *
+     * @return True if the recorded device is an IMU, false otherwise.
+     *
+     * @throws None
+     */
+    inline bool isImu(const PortSnapshot &snapshot, int port)
+    {
+        return is<pros::v5::DeviceType::imu>(snapshot, port);
+    }
+
+    /**
+     * Checks if a device is a radio at the given port.
+     *
+     * @param port The port number of the device.
+     *
+     * @return True if the device is a radio, false otherwise.
+     *
+     * @throws None
+     */
+    inline bool isRadio(int port)
+    {
+        return is<pros::v5::DeviceType::radio>(port);
+    }
+
+    /**
+     * Checks if the snapshot recorded a radio at the given port.
+     *
+     * @param snapshot The snapshot to read from.
+     * @param port The port number of the device.
+     *
+     * @return True if the recorded device is a radio, false otherwise.
+     *
+     * @throws None
+     */
+    inline bool isRadio(const PortSnapshot &snapshot, int port)
+    {
+        return is<pros::v5::DeviceType::radio>(snapshot, port);
+    }
+
+    /**
+     * Checks if a device is a rotation sensor at the given port.
+     *
+     * @param port The port number of the device.
+     *
+     * @return True if the device is a rotation sensor, false otherwise.
+     *
+     * @throws None
+     */
+    inline bool isRotation(int port)
+    {
+        return is<pros::v5::DeviceType::rotation>(port);
+    }
+
+    /**
+     * Checks if the snapshot recorded a rotation sensor at the given port.
+     *
+     * @param snapshot The snapshot to read from.
+     * @param port The port number of the device.
+     *
+     * @return True if the recorded device is a rotation sensor, false otherwise.
+     *
+     * @throws None
+     */
+    inline bool isRotation(const PortSnapshot &snapshot, int port)
+    {
+        return is<pros::v5::DeviceType::rotation>(snapshot, port);
+    }
+
+    /**
+     * The result of inspecting a MotorGroup. Each bad port appears in exactly one of the masks.
+     */
+    struct MotorGroupReport
+    {
+        PortMask missing;   ///< Ports with nothing plugged in.
+        PortMask wrongType; ///< Ports with a device plugged in that is not a motor.
+
+        /**
+         * Gets every port that is missing or holds the wrong type of device.
+         *
+         * @return The union of `missing` and `wrongType`.
+         *
+         * @throws None
+         */
+        PortMask bad() const
+        {
+            return missing | wrongType;
+        }
+
+        /**
+         * Checks if every port of the group holds a motor.
+         *
+         * @return True if no port is bad, false otherwise.
+         *
+         * @throws None
+         */
+        bool ok() const
+        {
+            return bad().empty();
+        }
+    };
+
+    /**
+     * Sorts a port into a MotorGroupReport based on the device type plugged into it.
+     *
+     * @param report The report to add the port to.
+     * @param port The port number of the device.
+     * @param type The device type plugged into the port.
+     *
+     * @throws None
+     */
+    inline void classifyMotorPort(MotorGroupReport &report, int port, pros::v5::DeviceType type)
+    {
+        if (type == pros::v5::DeviceType::motor)
+            return;
+        if (type == pros::v5::DeviceType::none || type == pros::v5::DeviceType::undefined)
+            report.missing.set(port);
+        else
+            report.wrongType.set(port);
+    }
+
+    /**
+     * Inspects the given MotorGroup, reading each port's type exactly once.
+     *
+     * @param group The MotorGroup to inspect.
+     *
+     * @return The ports that are missing and the ports that hold a device that is not a motor.
+     *
+     * @throws None
+     */
+    inline MotorGroupReport inspectMotorGroup(const pros::v5::MotorGroup &group)
+    {
+        SAFETY_PROFILE(inspectMotorGroup);
+        MotorGroupReport report;
+        for (int i = 0; i < group.size(); i++)
+        {
+            int port = std::abs(group.get_port(i));
+            classifyMotorPort(report, port, readPluggedType(port));
+        }
+        return report;
+    }
+
+    /**
+     * Inspects the given MotorGroup against a snapshot.
+     *
+     * @param snapshot The snapshot to read from.
+     * @param group The MotorGroup to inspect.
+     *
+     * @return The ports that are missing and the ports that hold a device that is not a motor.
+     *
+     * @throws None
+     */
+    inline MotorGroupReport inspectMotorGroup(const PortSnapshot &snapshot, const pros::v5::MotorGroup &group)
+    {
+        MotorGroupReport report;
+        for (int i = 0; i < group.size(); i++)
+        {
+            int port = std::abs(group.get_port(i));
+            classifyMotorPort(report, port, snapshot.type(port));
+        }
+        return report;
+    }
+
+    /**
+     * Checks the given MotorGroup for any ports that are not motors or are not plugged in.
+     *
+     * Each port is read once and reported at most once. Reversed motors are reported by their port number.
+     *
+     * @param group The MotorGroup to check.
+     *
+     * @return A vector of ports, in ascending order, that are not motors or are not plugged in.
+     *
+     * @throws None
+     */
+    inline std::vector<int> checkMotorGroup(const pros::v5::MotorGroup &group)
+    {
+        SAFETY_PROFILE(checkMotorGroup);
+        std::vector<int> ports;
+        for (int port : inspectMotorGroup(group).bad())
+            ports.push_back(port);
+        return ports;
+    }
+
+    /**
+     * Gets the ports used by the given MotorGroup.
+     *
+     * @param group The MotorGroup to read.
+     *
+     * @return A mask of the group's ports. Reversed motors are included by their port number.
+     *
+     * @throws None
+     */
+    inline PortMask portsOf(const pros::v5::MotorGroup &group)
+    {
+        PortMask mask;
+        for (int i = 0; i < group.size(); i++)
+            mask.set(group.get_port(i));
+        return mask;
+    }
+
+    /**
+     * Checks the given MotorGroup for any ports that are not motors, without allocating.
+     *
+     * Each port is read once and reported at most once, like the vector and mask overloads, so the list can never
+     * overflow. A port that is unplugged is not a motor, so it is reported as well.
+     *
+     * @param group The MotorGroup to check.
+     * @param out Cleared, then filled with the ports that are not motors, in ascending order.
+     *
+     * @return The number of ports written to `out`.
+     *
+     * @throws None
+     */
+    inline std::size_t checkMotorGroup(const pros::v5::MotorGroup &group, PortList &out)
+    {
+        SAFETY_PROFILE(checkMotorGroup);
+        out.clear();
+        for (int port : portsOf(group))
+        {
+            if (!isMotor(port))
+                out.push(port);
+        }
+        return out.size();
+    }
+
+    /**
+     * Checks the given MotorGroup against a snapshot for any ports that are not motors, without allocating.
+     *
+     * @param snapshot The snapshot to read from.
+     * @param group The MotorGroup to check.
+     * @param out Cleared, then filled with the ports that are not motors, in ascending order and each at most
+     *            once.
+     *
+     * @return The number of ports written to `out`.
+     *
+     * @throws None
+     */
+    inline std::size_t checkMotorGroup(const PortSnapshot &snapshot, const pros::v5::MotorGroup &group, PortList &out)
+    {
+        out.clear();
+        for (int port : portsOf(group))
+        {
+            if (!isMotor(snapshot, port))
+                out.push(port);
+        }
+        return out.size();
+    }
+
+    /**
+     * Checks the given MotorGroup for any ports that are not motors.
+     *
+     * @param group The MotorGroup to check.
+     *
+     * @return A mask of the ports that are not motors, including ports that are unplugged.
+     *
+     * @throws None
+     */
+    inline PortMask checkMotorGroupMask(const pros::v5::MotorGroup &group)
+    {
+        return inspectMotorGroup(group).bad();
+    }
+
+    /**
+     * Checks the given MotorGroup against a snapshot for any ports that are not motors.
+     *
+     * @param snapshot The snapshot to read from.
+     * @param group The MotorGroup to check.
+     *
+     * @return A mask of the ports that are not motors, including ports that are unplugged.
+     *
+     * @throws None
+     */
+    inline PortMask checkMotorGroupMask(const PortSnapshot &snapshot, const pros::v5::MotorGroup &group)
+    {
+        return portsOf(group) & ~snapshot.ofType(pros::v5::DeviceType::motor);
+    }
+
+    /**
+     * Checks if a device at the given port is an IMU and it is plugged in.
+     *
+     * @param port The port number of the device.
+     *
+     * @return True if the device is an IMU and is plugged in, false otherwise.
+     *
+     * @throws None
+     */
+    inline bool checkImu(int port)
+    {
+        // A port that reports an IMU is plugged in, so one type read answers both questions.
+        return isImu(port);
+    }
+
+    /**
+     * Checks if the snapshot recorded a plugged in IMU at the given port.
+     *
+     * @param snapshot The snapshot to read from.
+     * @param port The port number of the device.
+     *
+     * @return True if the recorded device is an IMU, false otherwise.
+     *
+     * @throws None
+     */
+    inline bool checkImu(const PortSnapshot &snapshot, int port)
+    {
+        return isImu(snapshot, port);
+    }
+
+    /**
+     * A function that checks a list of devices for being unplugged and returns a vector of ports that are unplugged.
+     *
+     * @param devices The vector of devices to check.
+     *
+     * @return A vector of ports that are unplugged.
+     *
+     * @throws None
+     */
+    inline std::vector<int> checkDevices(const std::vector<pros::v5::Device> &devices)
+    {
+        SAFETY_PROFILE(checkDevices);
+        std::vector<int> ports;
+        for (const pros::v5::Device &device : devices)
+        {
+            if (!isPluggedIn(device.get_port()))
+                ports.push_back(device.get_port());
+        }
+        return ports;
+    }
+
+    /**
+     * Checks a list of devices against a snapshot and returns a vector of ports that were unplugged.
+     *
+     * @param snapshot The snapshot to read from.
+     * @param devices The vector of devices to check.
+     *
+     * @return A vector of ports that are unplugged.
+     *
+     * @throws None
+     */
+    inline std::vector<int> checkDevices(const PortSnapshot &snapshot, const std::vector<pros::v5::Device> &devices)
+    {
+        std::vector<int> ports;
+        for (const pros::v5::Device &device : devices)
+        {
+            if (!isPluggedIn(snapshot, device.get_port()))
+                ports.push_back(device.get_port());
+        }
+        return ports;
+    }
+
+    /**
+     * Gets the ports used by a list of devices.
+     *
+     * @param devices The devices to read.
+     *
+     * @return A mask of the devices' ports.
+     *
+     * @throws None
+     */
+    inline PortMask portsOf(std::span<const pros::v5::Device> devices)
+    {
+        PortMask mask;
+        for (const pros::v5::Device &device : devices)
+            mask.set(device.get_port());
+        return mask;
+    }
+
+    /**
+     * Checks a list of devices for being unplugged, without allocating or copying the devices.
+     *
+     * Devices that share a port are checked and reported once, like the mask overloads, so the list can never
+     * overflow.
+     *
+     * @param devices The devices to check.
+     * @param out Cleared, then filled with the ports that are unplugged, in ascending order.
+     *
+     * @return The number of ports written to `out`.
+     *
+     * @throws None
+     */
+    inline std::size_t checkDevices(std::span<const pros::v5::Device> devices, PortList &out)
+    {
+        SAFETY_PROFILE(checkDevices);
+        out.clear();
+        for (int port : portsOf(devices))
+        {
+            if (!isPluggedIn(port))
+                out.push(port);
+        }
+        return out.size();
+    }
+
+    /**
+     * Checks a list of devices against a snapshot for being unplugged, without allocating or copying the devices.
+     *
+     * @param snapshot The snapshot to read from.
+     * @param devices The devices to check.
+     * @param out Cleared, then filled with the ports that are unplugged, in ascending order and each at most once.
+     *
+     * @return The number of ports written to `out`.
+     *
+     * @throws None
+     */
+    inline std::size_t checkDevices(const PortSnapshot &snapshot, std::span<const pros::v5::Device> devices,
+                                    PortList &out)
+    {
+        out.clear();
+        for (int port : portsOf(devices))
+        {
+            if (!isPluggedIn(snapshot, port))
+                out.push(port);
+        }
+        return out.size();
+    }
+
+    /**
+     * Checks a list of devices for being unplugged.
+     *
+     * @param devices The devices to check.
+     *
+     * @return A mask of the ports that are unplugged.
+     *
+     * @throws None
+     */
+    inline PortMask checkDevicesMask(std::span<const pros::v5::Device> devices)
+    {
+        PortMask mask;
+        for (const pros::v5::Device &device : devices)
+        {
+            if (!isPluggedIn(device.get_port()))
+                mask.set(device.get_port());
+        }
+        return mask;
+    }
+
+    /**
+     * Checks a list of devices against a snapshot for being unplugged.
+     *
+     * @param snapshot The snapshot to read from.
+     * @param devices The devices to check.
+     *
+     * @return A mask of the ports that are unplugged.
+     *
+     * @throws None
+     */
+    inline PortMask checkDevicesMask(const PortSnapshot &snapshot, std::span<const pros::v5::Device> devices)
+    {
+        return checkPorts(snapshot, portsOf(devices));
+    }
+
+    /**
+     * The ports of a list of devices, resolved once into a sorted array without duplicates.
+     *
+     * Build one from the robot's device list during `initialize` and pass it to the `DeviceSet` overloads of
+     * `checkDevices`, `checkDevicesMask`, `format_devices`, and `format_unplugged_devices`. They walk the compact
+     * 21-byte array instead of calling `get_port` on every `pros::v5::Device` each time. The set also keeps the
+     * equivalent `PortMask` for the snapshot-based checks.
+     */
+    class DeviceSet
+    {
+    public:
+        /**
+         * Creates an empty set.
+         */
+        constexpr DeviceSet() = default;
+
+        /**
+         * Creates a set from the ports in a mask.
+         *
+         * @param ports The ports to hold.
+         */
+        constexpr explicit DeviceSet(PortMask ports)
+        {
+            assign(ports);
+        }
+
+        /**
+         * Creates a set from a list of port numbers. Reversed (negative) ports count as their absolute value,
+         * and out of range ports are ignored.
+         *
+         * @param ports The ports to hold.
+         */
+        constexpr DeviceSet(std::initializer_list<int> ports)
+        {
+            PortMask mask;
+            for (int port : ports)
+                mask.set(port < 0 ? -port : port);
+            assign(mask);
+        }
+
+        /**
+         * Creates a set from the ports of some devices. This is the only time the devices are read.
+         *
+         * @param devices The devices to resolve.
+         */
+        explicit DeviceSet(std::span<const pros::v5::Device> devices)
+        {
+            assign(portsOf(devices));
+        }
+
+        /**
+         * Gets the number of ports in the set.
+         *
+         * @return The number of ports.
+         *
+         * @throws None
+         */
+        constexpr std::size_t size() const
+        {
+            return size_;
+        }
+
+        /**
+         * Checks if the set holds no ports.
+         *
+         * @return True if the set is empty, false otherwise.
+         *
+         * @throws None
+         */
+        constexpr bool empty() const
+        {
+            return size_ == 0;
+        }
+
+        /**
+         * Checks if a port is in the set.
+         *
+         * @param port The port number to look for.
+         *
+         * @return True if the port is in the set, false otherwise.
+         *
+         * @throws None
+         */
+        constexpr bool contains(int port) const
+        {
+            return mask_.test(port);
+        }
+
+        /**
+         * Gets the ports of the set as a mask.
+         *
+         * @return The mask of the set's ports.
+         *
+         * @throws None
+         */
+        constexpr PortMask ports() const
+        {
+            return mask_;
+        }
+
+        /**
+         * Gets the first port of the set, in ascending order.
+         *
+         * @return A pointer to the first port number.
+         *
+         * @throws None
+         */
+        constexpr const std::uint8_t *begin() const
+        {
+            return ports_.data();
+        }
+
+        /**
+         * Gets the end of the set's ports.
+         *
+         * @return A pointer past the last port number.
+         *
+         * @throws None
+         */
+        constexpr const std::uint8_t *end() const
+        {
+            return ports_.data() + size_;
+        }
+
+    private:
+        constexpr void assign(PortMask ports)
+        {
+            mask_ = ports;
+            size_ = 0;
+            for (int port : ports)
+                ports_[size_++] = static_cast<std::uint8_t>(port);
+        }
+
+        std::array<std::uint8_t, SMART_PORT_COUNT> ports_{};
+        std::uint8_t size_ = 0;
+        PortMask mask_;
+    };
+
+    /**
+     * Checks the ports of a device set for being unplugged.
+     *
+     * @param devices The ports to check.
+     * @param out Cleared, then filled with the ports that are unplugged, in ascending order.
+     *
+     * @return The number of ports written to `out`.
+     *
+     * @throws None
+     */
+    inline std::size_t checkDevices(const DeviceSet &devices, PortList &out)
+    {
+        SAFETY_PROFILE(checkDevices);
+        out.clear();
+        for (std::uint8_t port : devices)
+        {
+            if (!isPluggedIn(port))
+                out.push(port);
+        }
+        return out.size();
+    }
+
+    /**
+     * Checks the ports of a device set against a snapshot for being unplugged.
+     *
+     * @param snapshot The snapshot to read from.
+     * @param devices The ports to check.
+     * @param out Cleared, then filled with the ports that are unplugged, in ascending order.
+     *
+     * @return The number of ports written to `out`.
+     *
+     * @throws None
+     */
+    inline std::size_t checkDevices(const PortSnapshot &snapshot, const DeviceSet &devices, PortList &out)
+    {
+        out.clear();
+        for (std::uint8_t port : devices)
+        {
+            if (!isPluggedIn(snapshot, port))
+                out.push(port);
+        }
+        return out.size();
+    }
+
+    /**
+     * Checks the ports of a device set for being unplugged.
+     *
+     * @param devices The ports to check.
+     *
+     * @return A mask of the ports that are unplugged.
+     *
+     * @throws None
+     */
+    inline PortMask checkDevicesMask(const DeviceSet &devices)
+    {
+        SAFETY_PROFILE(checkDevices);
+        PortMask mask;
+        for (std::uint8_t port : devices)
+        {
+            if (!isPluggedIn(port))
+                mask.set(port);
+        }
+        return mask;
+    }
+
+    /**
+     * Checks the ports of a device set against a snapshot for being unplugged.
+     *
+     * @param snapshot The snapshot to read from.
+     * @param devices The ports to check.
+     *
+     * @return A mask of the ports that are unplugged.
+     *
+     * @throws None
+     */
+    inline PortMask checkDevicesMask(const PortSnapshot &snapshot, const DeviceSet &devices)
+    {
+        return checkPorts(snapshot, devices.ports());
+    }
+
+    /**
+     * A `pros::v5::DeviceType` and the name `deviceType_to_string` gives it.
+     */
+    struct DeviceTypeName
+    {
+        pros::v5::DeviceType type; ///< The device type.
+        const char *name;          ///< Its name.
+    };
+
+    /**
+     * The name of every named `pros::v5::DeviceType`, sorted by the enum's numeric value so it can be searched
+     * with a few comparisons. Values that are not listed are "unknown".
+     */
+    inline constexpr std::array<DeviceTypeName, 12> DEVICE_TYPE_NAMES{{
+        {pros::v5::DeviceType::none, "none"},
+        {pros::v5::DeviceType::motor, "motor"},
+        {pros::v5::DeviceType::rotation, "rotation"},
+        {pros::v5::DeviceType::imu, "imu"},
+        {pros::v5::DeviceType::distance, "distance"},
+        {pros::v5::DeviceType::radio, "radio"},
+        {pros::v5::DeviceType::vision, "vision"},
+        {pros::v5::DeviceType::adi, "adi"},
+        {pros::v5::DeviceType::optical, "optical"},
+        {pros::v5::DeviceType::gps, "gps"},
+        {pros::v5::DeviceType::serial, "serial"},
+        {pros::v5::DeviceType::undefined, "undefined"},
+    }};
+
+    /**
+     * Checks that `DEVICE_TYPE_NAMES` is sorted by value with no repeats, which its lookup relies on.
+     *
+     * @return True if the table is strictly ascending, false otherwise.
+     *
+     * @throws None
+     */
+    constexpr bool deviceTypeNamesSorted()
+    {
+        for (std::size_t i = 1; i < DEVICE_TYPE_NAMES.size(); i++)
+        {
+            unsigned previous = static_cast<unsigned>(DEVICE_TYPE_NAMES[i - 1].type);
+            if (previous >= static_cast<unsigned>(DEVICE_TYPE_NAMES[i].type))
+                return false;
+        }
+        return true;
+    }
+
+    static_assert(deviceTypeNamesSorted(), "DEVICE_TYPE_NAMES must be sorted by value");
+
+    /**
+     * @brief Converts a `pros::v5::DeviceType` enum value to its corresponding string representation.
+     *
+     * @param type The `pros::v5::DeviceType` enum value to convert.
+     *
+     * @return A string representation of the `pros::v5::DeviceType` enum value: "none", "undefined", "motor",
+     * "rotation", "imu", "radio", "distance", "vision", "adi", "optical", "gps", or "serial" for the matching
+     * `pros::v5::DeviceType` value, and "unknown" for any other value.
+     *
+     * The conversion is a binary search of `DEVICE_TYPE_NAMES`, and it can be evaluated at compile time.
+     *
+     * @throws None
+     */
+    constexpr const char *deviceType_to_string(pros::v5::DeviceType type)
+    {
+        unsigned value = static_cast<unsigned>(type);
+        std::size_t low = 0;
+        std::size_t high = DEVICE_TYPE_NAMES.size();
+        while (low < high)
+        {
+            std::size_t middle = (low + high) / 2;
+            if (static_cast<unsigned>(DEVICE_TYPE_NAMES[middle].type) < value)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        if (low < DEVICE_TYPE_NAMES.size() && DEVICE_TYPE_NAMES[low].type == type)
+            return DEVICE_TYPE_NAMES[low].name;
+        return "unknown";
+    }
+
+    /**
+     * The device type a robot expects on one smart port.
+     */
+    struct PortExpectation
+    {
+        int port;                  ///< The smart port, from 1 to 21.
+        pros::v5::DeviceType type; ///< The device type that should be plugged into the port.
+        std::uint8_t tier = 0;     ///< The watchdog scan tier of the port; see `ScanSchedule`.
+    };
+
+    /**
+     * Checks that every expectation names a smart port from 1 to 21.
+     *
+     * @param entries The expectations to check.
+     *
+     * @return True if every port is in range, false otherwise.
+     *
+     * @throws None
+     */
+    template <std::size_t N>
+    constexpr bool portsInRange(const std::array<PortExpectation, N> &entries)
+    {
+        for (const PortExpectation &entry : entries)
+        {
+            if (entry.port < 1 || entry.port > SMART_PORT_COUNT)
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * Checks that no two expectations name the same port.
+     *
+     * @param entries The expectations to check.
+     *
+     * @return True if every port appears at most once, false otherwise.
+     *
+     * @throws None
+     */
+    template <std::size_t N>
+    constexpr bool portsUnique(const std::array<PortExpectation, N> &entries)
+    {
+        std::uint32_t seen = 0;
+        for (const PortExpectation &entry : entries)
+        {
+            std::uint32_t bit = PortMask({entry.port}).bits();
+            if (seen & bit)
+                return false;
+            seen |= bit;
+        }
+        return true;
+    }
+
+    /**
+     * A robot manifest declared at compile time: which device type belongs on which port.
+     *
+     * Out of range and duplicate ports fail a `static_assert` as soon as the manifest is used. Validating a
+     * snapshot is then a single loop over a compile-time array.
+     *
+     * @code
+     * using Robot = safety::StaticManifest<{1, pros::v5::DeviceType::motor},
+     *                                      {2, pros::v5::DeviceType::motor},
+     *                                      {10, pros::v5::DeviceType::imu}>;
+     * safety::PortMask bad = Robot::mismatches(safety::PortSnapshot::capture());
+     * @endcode
+     *
+     * @tparam Entries The expected device type of each port in the manifest.
+     */
+    template <PortExpectation... Entries>
+    struct StaticManifest
+    {
+        /**
+         * The expectations, in the order they were declared.
+         */
+        static constexpr std::array<PortExpectation, sizeof...(Entries)> entries{Entries...};
+
+        static_assert(portsInRange(entries), "StaticManifest ports must be between 1 and 21");
+        static_assert(portsUnique(entries), "StaticManifest lists the same port more than once");
+
+        /**
+         * Gets every port named by the manifest.
+         *
+         * @return A mask of the manifest's ports.
+         *
+         * @throws None
+         */
+        static constexpr PortMask ports()
+        {
+            PortMask mask;
+            for (const PortExpectation &entry : entries)
+                mask.set(entry.port);
+            return mask;
+        }
+
+        /**
+         * Gets the device type the manifest expects on a port.
+         *
+         * @param port The port number to look up.
+         *
+         * @return The expected type, or `pros::v5::DeviceType::none` if the port is not in the manifest.
+         *
+         * @throws None
+         */
+        static constexpr pros::v5::DeviceType expected(int port)
+        {
+            for (const PortExpectation &entry : entries)
+            {
+                if (entry.port == port)
+                    return entry.type;
+            }
+            return pros::v5::DeviceType::none;
+        }
+
+        /**
+         * Finds the ports whose recorded type does not match the manifest.
+         *
+         * @param snapshot The snapshot to validate.
+         *
+         * @return A mask of the ports that are missing or hold the wrong device type.
+         *
+         * @throws None
+         */
+        static PortMask mismatches(const PortSnapshot &snapshot)
+        {
+            PortMask bad;
+            for (const PortExpectation &entry : entries)
+            {
+                if (snapshot.type(entry.port) != entry.type)
+                    bad.set(entry.port);
+            }
+            return bad;
+        }
+    };
+
+    /**
+     * The buffer size that always fits the output of `format_devices` and `format_unplugged_devices` for one
+     * device on every smart port, including the terminating null character.
+     */
+    inline constexpr std::size_t DEVICE_TEXT_CAPACITY = SMART_PORT_COUNT * 16 + 1;
+
+    /**
+     * Appends text to a caller-provided character buffer without allocating.
+     *
+     * The buffer is always null terminated. Text that does not fit is dropped but still counted, so `length()`
+     * works like the return value of `snprintf`.
+     */
+    class TextWriter
+    {
+    public:
+        /**
+         * Creates a writer over the given buffer and empties it.
+         *
+         * @param out The buffer to write into.
+         */
+        explicit TextWriter(std::span<char> out) : out_(out)
+        {
+            if (!out_.empty())
+                out_[0] = '\0';
+        }
+
+        /**
+         * Appends a null-terminated string.
+         *
+         * @param text The string to append.
+         *
+         * @return This writer.
+         *
+         * @throws None
+         */
+        TextWriter &append(const char *text)
+        {
+            while (*text)
+                put(*text++);
+            return *this;
+        }
+
+        /**
+         * Appends a single character.
+         *
+         * @param c The character to append.
+         *
+         * @return This writer.
+         *
+         * @throws None
+         */
+        TextWriter &append(char c)
+        {
+            put(c);
+            return *this;
+        }
+
+        /**
+         * Appends an unsigned number in decimal.
+         *
+         * @param value The number to append.
+         *
+         * @return This writer.
+         *
+         * @throws None
+         */
+        TextWriter &append(std::uint32_t value)
+        {
+            char digits[10];
+            int count = 0;
+            do
+            {
+                digits[count++] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            } while (value != 0);
+            while (count > 0)
+                put(digits[--count]);
+            return *this;
+        }
+
+        /**
+         * Gets the length the text would have if the buffer were large enough.
+         *
+         * @return The number of characters appended, not counting the null terminator.
+         *
+         * @throws None
+         */
+        std::size_t length() const
+        {
+            return length_;
+        }
+
+        /**
+         * Checks if any text was dropped because the buffer was full.
+         *
+         * @return True if the text was truncated, false otherwise.
+         *
+         * @throws None
+         */
+        bool truncated() const
+        {
+            return !out_.empty() && length_ >= out_.size();
+        }
+
+    private:
+        void put(char c)
+        {
+            if (length_ + 1 < out_.size())
+            {
+                out_[length_] = c;
+                out_[length_ + 1] = '\0';
+            }
+            length_++;
+        }
+
+        std::span<char> out_;
+        std::size_t length_ = 0;
+    };
+
+    /**
+     * Writes each plugged in device's type and port into a buffer as lines of the form `motor: 1,`.
+     *
+     * @param out The buffer to write into. It is always null terminated if it is not empty.
+     * @param devices The devices to list.
+     *
+     * @return The length the text would have without truncation, like `snprintf`.
+     *
+     * @throws None
+     */
+    inline std::size_t format_devices(std::span<char> out, std::span<const pros::v5::Device> devices)
+    {
+        SAFETY_PROFILE(formatDevices);
+        TextWriter writer(out);
+        for (const pros::v5::Device &device : devices)
+        {
+            pros::v5::DeviceType type = readPluggedType(device.get_port());
+            if (type == pros::v5::DeviceType::none || type == pros::v5::DeviceType::undefined)
+                continue;
+            writer.append(deviceType_to_string(type)).append(": ").append(std::uint32_t(device.get_port())).append(",\n");
+        }
+        return writer.length();
+    }
+
+    /**
+     * Writes each plugged in device's type and port, as recorded by a snapshot, into a buffer.
+     *
+     * @param out The buffer to write into. It is always null terminated if it is not empty.
+     * @param snapshot The snapshot to read from.
+     * @param devices The devices to list.
+     *
+     * @return The length the text would have without truncation, like `snprintf`.
+     *
+     * @throws None
+     */
+    inline std::size_t format_devices(std::span<char> out, const PortSnapshot &snapshot,
+                                      std::span<const pros::v5::Device> devices)
+    {
+        TextWriter writer(out);
+        for (const pros::v5::Device &device : devices)
+        {
+            if (!isPluggedIn(snapshot, device.get_port()))
+                continue;
+            writer.append(deviceType_to_string(snapshot.type(device.get_port())))
+                .append(": ")
+                .append(std::uint32_t(device.get_port()))
+                .append(",\n");
+        }
+        return writer.length();
+    }
+
+    /**
+     * Writes the port of each unplugged device into a buffer as lines of the form `unplugged: 1,`.
+     *
+     * @param out The buffer to write into. It is always null terminated if it is not empty.
+     * @param devices The devices to check.
+     *
+     * @return The length the text would have without truncation, like `snprintf`.
+     *
+     * @throws None
+     */
+    inline std::size_t format_unplugged_devices(std::span<char> out, std::span<const pros::v5::Device> devices)
+    {
+        SAFETY_PROFILE(formatDevices);
+        TextWriter writer(out);
+        for (const pros::v5::Device &device : devices)
+        {
+            if (!isPluggedIn(device.get_port()))
+                writer.append("unplugged: ").append(std::uint32_t(device.get_port())).append(",\n");
+        }
+        return writer.length();
+    }
+
+    /**
+     * Writes the port of each device the snapshot recorded as unplugged into a buffer.
+     *
+     * @param out The buffer to write into. It is always null terminated if it is not empty.
+     * @param snapshot The snapshot to read from.
+     * @param devices The devices to check.
+     *
+     * @return The length the text would have without truncation, like `snprintf`.
+     *
+     * @throws None
+     */
+    inline std::size_t format_unplugged_devices(std::span<char> out, const PortSnapshot &snapshot,
+                                                std::span<const pros::v5::Device> devices)
+    {
+        TextWriter writer(out);
+        for (const pros::v5::Device &device : devices)
+        {
+            if (!isPluggedIn(snapshot, device.get_port()))
+                writer.append("unplugged: ").append(std::uint32_t(device.get_port())).append(",\n");
+        }
+        return writer.length();
+    }
+
+    /**
+     * Writes the type and port of each plugged in port of a device set into a buffer, in ascending port order.
+     *
+     * @param out The buffer to write into. It is always null terminated if it is not empty.
+     * @param devices The ports to list.
+     *
+     * @return The length the text would have without truncation, like `snprintf`.
+     *
+     * @throws None
+     */
+    inline std::size_t format_devices(std::span<char> out, const DeviceSet &devices)
+    {
+        SAFETY_PROFILE(formatDevices);
+        TextWriter writer(out);
+        for (std::uint8_t port : devices)
+        {
+            pros::v5::DeviceType type = readPluggedType(port);
+            if (type == pros::v5::DeviceType::none || type == pros::v5::DeviceType::undefined)
+                continue;
+            writer.append(deviceType_to_string(type)).append(": ").append(std::uint32_t(port)).append(",\n");
+        }
+        return writer.length();
+    }
+
+    /**
+     * Writes the type and port of each port of a device set that a snapshot recorded as plugged in.
+     *
+     * @param out The buffer to write into. It is always null terminated if it is not empty.
+     * @param snapshot The snapshot to read from.
+     * @param devices The ports to list.
+     *
+     * @return The length the text would have without truncation, like `snprintf`.
+     *
+     * @throws None
+     */
+    inline std::size_t format_devices(std::span<char> out, const PortSnapshot &snapshot, const DeviceSet &devices)
+    {
+        TextWriter writer(out);
+        for (std::uint8_t port : devices)
+        {
+            if (!isPluggedIn(snapshot, port))
+                continue;
+            writer.append(deviceType_to_string(snapshot.type(port)))
+                .append(": ")
+                .append(std::uint32_t(port))
+                .append(",\n");
+        }
+        return writer.length();
+    }
+
+    /**
+     * Writes each unplugged port of a device set into a buffer as lines of the form `unplugged: 1,`.
+     *
+     * @param out The buffer to write into. It is always null terminated if it is not empty.
+     * @param devices The ports to check.
+     *
+     * @return The length the text would have without truncation, like `snprintf`.
+     *
+     * @throws None
+     */
+    inline std::size_t format_unplugged_devices(std::span<char> out, const DeviceSet &devices)
+    {
+        SAFETY_PROFILE(formatDevices);
+        TextWriter writer(out);
+        for (std::uint8_t port : devices)
+        {
+            if (!isPluggedIn(port))
+                writer.append("unplugged: ").append(std::uint32_t(port)).append(",\n");
+        }
+        return writer.length();
+    }
+
+    /**
+     * Writes each port of a device set that a snapshot recorded as unplugged into a buffer.
+     *
+     * @param out The buffer to write into. It is always null terminated if it is not empty.
+     * @param snapshot The snapshot to read from.
+     * @param devices The ports to check.
+     *
+     * @return The length the text would have without truncation, like `snprintf`.
+     *
+     * @throws None
+     */
+    inline std::size_t format_unplugged_devices(std::span<char> out, const PortSnapshot &snapshot,
+                                                const DeviceSet &devices)
+    {
+        TextWriter writer(out);
+        for (std::uint8_t port : devices)
+        {
+            if (!isPluggedIn(snapshot, port))
+                writer.append("unplugged: ").append(std::uint32_t(port)).append(",\n");
+        }
+        return writer.length();
+    }
+
+    /**
+     * A function that generates a string of plugged-in devices with their types and ports.
+     *
+     * Despite its name, this lists the devices that are plugged in; use `format_unplugged_devices` for the ones
+     * that are not. The text is written into a static buffer that is overwritten by the next call, so this is
+     * not safe to call from two tasks at once. Prefer `format_devices` with a buffer you own.
+     *
+     * @param devices The vector of devices to check for being plugged in.
+     *
+     * @return A C-style string of plugged-in devices with their types and ports.
+     *
+     * @throws None
+     */
+    inline const char *print_unplugged_devices(const std::vector<pros::v5::Device> &devices)
+    {
+        static char output[DEVICE_TEXT_CAPACITY];
+        format_devices(output, devices);
+        return output;
+    }
+
+    /**
+     * Generates a string of the plugged-in ports of a device set with their types, like the vector overload.
+     *
+     * The text is written into the same kind of static buffer, so this is not safe to call from two tasks at once.
+     *
+     * @param devices The ports to check for being plugged in.
+     *
+     * @return A C-style string of plugged-in devices with their types and ports.
+     *
+     * @throws None
+     */
+    inline const char *print_unplugged_devices(const DeviceSet &devices)
+    {
+        static char output[DEVICE_TEXT_CAPACITY];
+        format_devices(output, devices);
+        return output;
+    }
+
+    /**
+     * A fixed-capacity, lock-free queue for one producer task and one consumer task.
+     *
+     * `push` must only be called from the producer and `pop` only from the consumer. Neither call allocates or
+     * blocks, so the queue is safe to use from the control loop.
+     *
+     * @tparam T The type of item stored in the queue.
+     * @tparam Capacity The maximum number of queued items. Must be a power of two.
+     */
+    template <typename T, std::size_t Capacity>
+    class SpscRing
+    {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+    public:
+        /**
+         * Adds an item to the back of the queue.
+         *
+         * @param item The item to add.
+         *
+         * @return True if the item was added, false if the queue was full.
+         *
+         * @throws None
+         */
+        bool push(const T &item)
+        {
+            std::size_t head = head_.load(std::memory_order_relaxed);
+            if (head - tail_.load(std::memory_order_acquire) == Capacity)
+                return false;
+            items_[head & (Capacity - 1)] = item;
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Removes the item at the front of the queue.
+         *
+         * @param item Receives the removed item.
+         *
+         * @return True if an item was removed, false if the queue was empty.
+         *
+         * @throws None
+         */
+        bool pop(T &item)
+        {
+            std::size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail == head_.load(std::memory_order_acquire))
+                return false;
+            item = items_[tail & (Capacity - 1)];
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Gets the number of items in the queue. The value may be stale by the time it is used.
+         *
+         * @return The number of queued items.
+         *
+         * @throws None
+         */
+        std::size_t size() const
+        {
+            return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+        }
+
+        /**
+         * Checks if the queue has no items.
+         *
+         * @return True if the queue is empty, false otherwise.
+         *
+         * @throws None
+         */
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        /**
+         * Gets the maximum number of items the queue can hold.
+         *
+         * @return The capacity of the queue.
+         *
+         * @throws None
+         */
+        static constexpr std::size_t capacity()
+        {
+            return Capacity;
+        }
+
+    private:
+        std::array<T, Capacity> items_{};
+        std::atomic<std::size_t> head_{0};
+        std::atomic<std::size_t> tail_{0};
+    };
+
+    /**
+     * A `PortSnapshot` that one task publishes and any number of tasks read, without a mutex.
+     *
+     * The snapshot is kept in two buffers of atomic words next to a version counter. `publish` fills the buffer
+     * that readers are not using and then bumps the version, so the writer never waits. `read` copies the buffer
+     * named by the version and retries only if the version moved while it was copying, which needs two full
+     * publishes to land during the copy. A reader that preempts the writer mid-publish reads the other, complete
+     * buffer, so a high-priority reader never spins waiting for a low-priority writer to finish.
+     */
+    class SharedSnapshot
+    {
+    public:
+        /**
+         * Creates a shared snapshot that reports every port as `pros::v5::DeviceType::none`.
+         */
+        SharedSnapshot()
+        {
+            PortSnapshot empty;
+            store(buffers_[0], empty);
+            store(buffers_[1], empty);
+        }
+
+        SharedSnapshot(const SharedSnapshot &) = delete;
+        SharedSnapshot &operator=(const SharedSnapshot &) = delete;
+
+        /**
+         * Makes a snapshot visible to readers. Call this from a single writer task.
+         *
+         * @param snapshot The snapshot to publish.
+         *
+         * @throws None
+         */
+        void publish(const PortSnapshot &snapshot)
+        {
+            std::uint32_t next = version_.load(std::memory_order_relaxed) + 1;
+            // Keeps the new words from becoming visible before the previous version bump.
+            std::atomic_thread_fence(std::memory_order_release);
+            store(buffers_[next & 1], snapshot);
+            version_.store(next, std::memory_order_release);
+        }
+
+        /**
+         * Copies the latest published snapshot. Safe to call from any task, including one that preempts the writer.
+         *
+         * @param out Overwritten with a consistent copy of every port.
+         *
+         * @return The version of the copy.
+         *
+         * @throws None
+         */
+        std::uint32_t read(PortSnapshot &out) const
+        {
+            while (true)
+            {
+                std::uint32_t before = version_.load(std::memory_order_acquire);
+                load(buffers_[before & 1], out);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (version_.load(std::memory_order_relaxed) == before)
+                    return before;
+            }
+        }
+
+        /**
+         * Copies the latest published snapshot. Safe to call from any task, including one that preempts the writer.
+         *
+         * @return A consistent copy of every port.
+         *
+         * @throws None
+         */
+        PortSnapshot read() const
+        {
+            PortSnapshot out;
+            read(out);
+            return out;
+        }
+
+        /**
+         * Gets the number of snapshots published so far, so a reader can skip work when nothing is new.
+         *
+         * @return The current version.
+         *
+         * @throws None
+         */
+        std::uint32_t version() const
+        {
+            return version_.load(std::memory_order_acquire);
+        }
+
+    private:
+        static constexpr std::size_t TYPE_WORDS = (SMART_PORT_COUNT + 3) / 4;
+
+        struct Buffer
+        {
+            std::array<std::atomic<std::uint32_t>, TYPE_WORDS> types{};
+            std::atomic<std::uint32_t> time{0};
+        };
+
+        static void store(Buffer &buffer, const PortSnapshot &snapshot)
+        {
+            for (std::size_t word = 0; word < TYPE_WORDS; word++)
+            {
+                std::uint32_t packed = 0;
+                for (std::size_t byte = 0; byte < 4; byte++)
+                {
+                    int port = static_cast<int>(word * 4 + byte) + 1;
+                    if (port <= SMART_PORT_COUNT)
+                        packed |= std::uint32_t(static_cast<std::uint8_t>(snapshot.type(port))) << (byte * 8);
+                }
+                buffer.types[word].store(packed, std::memory_order_relaxed);
+            }
+            buffer.time.store(snapshot.timestamp(), std::memory_order_relaxed);
+        }
+
+        static void load(const Buffer &buffer, PortSnapshot &out)
+        {
+            for (std::size_t word = 0; word < TYPE_WORDS; word++)
+            {
+                std::uint32_t packed = buffer.types[word].load(std::memory_order_relaxed);
+                for (std::size_t byte = 0; byte < 4; byte++)
+                {
+                    std::size_t index = word * 4 + byte;
+                    if (index < SMART_PORT_COUNT)
+                        out.types_[index] = static_cast<std::uint8_t>(packed >> (byte * 8));
+                }
+            }
+            out.time_ = buffer.time.load(std::memory_order_relaxed);
+        }
+
+        std::array<Buffer, 2> buffers_;
+        std::atomic<std::uint32_t> version_{0};
+    };
+
+    /**
+     * The kind of change the watchdog saw on a port.
+     */
+    enum class PortEventKind : std::uint8_t
+    {
+        plugged,   ///< A device appeared on an empty port.
+        unplugged, ///< The device on the port went away.
+        changed    ///< A different type of device is now on the port.
+    };
+
+    /**
+     * A change in the device type of a single port, as seen between two watchdog samples.
+     */
+    struct PortEvent
+    {
+        std::uint32_t time;            ///< The value of `pros::millis()` when the change was seen.
+        std::uint8_t port;             ///< The smart port that changed.
+        PortEventKind kind;            ///< What kind of change happened.
+        pros::v5::DeviceType previous; ///< The device type before the change.
+        pros::v5::DeviceType current;  ///< The device type after the change.
+    };
+
+    /**
+     * How long a new device type must persist on a port before the watchdog reports it.
+     *
+     * A change is reported once it has been seen on `samples` consecutive samples and has lasted at least
+     * `hold_ms` milliseconds. Set only one of the two to debounce by sample count or by time alone.
+     */
+    struct DebounceConfig
+    {
+        std::uint8_t samples = 1;  ///< Consecutive samples that must agree on the new type.
+        std::uint32_t hold_ms = 0; ///< Minimum time the new type must persist.
+    };
+
+    /**
+     * Filters single-sample glitches out of the device type of every smart port.
+     *
+     * Each port keeps its last stable type and the candidate type it is moving to. The per-port state is stored
+     * as parallel arrays so the whole debouncer fits in about 150 bytes.
+     */
+    class PortDebouncer
+    {
+    public:
+        /**
+         * Creates a debouncer that treats every port as empty.
+         *
+         * @param config The hysteresis to apply.
+         */
+        explicit PortDebouncer(DebounceConfig config = {}) : config_(config)
+        {
+            reset(PortSnapshot());
+        }
+
+        /**
+         * Sets the hysteresis to apply to future samples.
+         *
+         * @param config The hysteresis to apply.
+         *
+         * @throws None
+         */
+        void configure(DebounceConfig config)
+        {
+            config_ = config;
+        }
+
+        /**
+         * Accepts every port of a snapshot as stable and forgets any pending changes.
+         *
+         * @param baseline The snapshot to treat as stable.
+         *
+         * @throws None
+         */
+        void reset(const PortSnapshot &baseline)
+        {
+            for (int port = 1; port <= SMART_PORT_COUNT; port++)
+            {
+                stable_[port - 1] = static_cast<std::uint8_t>(baseline.type(port));
+                candidate_[port - 1] = stable_[port - 1];
+                count_[port - 1] = 0;
+                since_[port - 1] = 0;
+            }
+        }
+
+        /**
+         * Feeds one observation of a port into the debouncer.
+         *
+         * @param port The port that was read, from 1 to 21.
+         * @param observed The device type that was read.
+         * @param now The time of the read in milliseconds.
+         *
+         * @return True if the port's stable type changed to `observed`, false otherwise.
+         *
+         * @throws None
+         */
+        bool update(int port, pros::v5::DeviceType observed, std::uint32_t now)
+        {
+            int i = port - 1;
+            std::uint8_t value = static_cast<std::uint8_t>(observed);
+            if (value == stable_[i])
+            {
+                candidate_[i] = value;
+                count_[i] = 0;
+                return false;
+            }
+            if (value != candidate_[i] || count_[i] == 0)
+            {
+                candidate_[i] = value;
+                count_[i] = 1;
+                since_[i] = now;
+            }
+            else if (count_[i] < UINT8_MAX)
+            {
+                count_[i]++;
+            }
+
+            if (count_[i] < config_.samples || now - since_[i] < config_.hold_ms)
+                return false;
+            stable_[i] = value;
+            count_[i] = 0;
+            return true;
+        }
+
+        /**
+         * Gets the last stable device type of a port.
+         *
+         * @param port The port number, from 1 to 21.
+         *
+         * @return The stable type.
+         *
+         * @throws None
+         */
+        pros::v5::DeviceType stable(int port) const
+        {
+            return static_cast<pros::v5::DeviceType>(stable_[port - 1]);
+        }
+
+        /**
+         * Gets the ports whose latest reading differs from their stable type.
+         *
+         * @return A mask of the ports with a change that has not settled yet.
+         *
+         * @throws None
+         */
+        PortMask pending() const
+        {
+            PortMask mask;
+            for (int port = 1; port <= SMART_PORT_COUNT; port++)
+            {
+                if (count_[port - 1] != 0)
+                    mask.set(port);
+            }
+            return mask;
+        }
+
+    private:
+        DebounceConfig config_;
+        std::array<std::uint8_t, SMART_PORT_COUNT> stable_;
+        std::array<std::uint8_t, SMART_PORT_COUNT> candidate_;
+        std::array<std::uint8_t, SMART_PORT_COUNT> count_;
+        std::array<std::uint32_t, SMART_PORT_COUNT> since_;
+    };
+
+    /**
+     * How the radio monitor samples the link and when it considers it degraded.
+     */
+    struct RadioMonitorConfig
+    {
+        std::uint8_t every = 10;    ///< Watchdog samples between two link checks.
+        std::uint8_t window = 16;   ///< Number of recent link checks to keep, from 1 to 32.
+        std::uint8_t threshold = 4; ///< Bad checks within the window that mark the link as degraded.
+    };
+
+    /**
+     * Tracks the health of the radio link over a small rolling window.
+     *
+     * A link check is bad if no radio is plugged in or the master controller is not connected. The window is a
+     * 32-bit shift register used as a ring of one-bit samples, so adding a check and reading the degraded flag are
+     * both constant time. The flag can be read from any task.
+     */
+    class RadioMonitor
+    {
+    public:
+        /**
+         * Creates a monitor with an empty window.
+         *
+         * @param config How to sample the link.
+         */
+        explicit RadioMonitor(RadioMonitorConfig config = {}) : config_(config)
+        {
+        }
+
+        /**
+         * Sets how to sample the link and clears the window.
+         *
+         * @param config How to sample the link.
+         *
+         * @throws None
+         */
+        void configure(RadioMonitorConfig config)
+        {
+            config_ = config;
+            history_ = 0;
+            ticks_ = 0;
+            degraded_.store(false, std::memory_order_relaxed);
+        }
+
+        /**
+         * Counts one watchdog sample and checks the link if it is due.
+         *
+         * @param snapshot The watchdog's latest snapshot, used to find the radio without another port read.
+         *
+         * @throws None
+         */
+        void tick(const PortSnapshot &snapshot)
+        {
+            if (++ticks_ < config_.every)
+                return;
+            ticks_ = 0;
+            sample(snapshot);
+        }
+
+        /**
+         * Checks the link once and adds the result to the window.
+         *
+         * @param snapshot A snapshot used to find the radio without another port read.
+         *
+         * @throws None
+         */
+        void sample(const PortSnapshot &snapshot)
+        {
+            bool bad = snapshot.ofType(pros::v5::DeviceType::radio).empty() ||
+                       pros::c::controller_is_connected(pros::c::E_CONTROLLER_MASTER) != 1;
+            history_ = (history_ << 1) | (bad ? 1 : 0);
+            degraded_.store(badSamples() >= config_.threshold, std::memory_order_relaxed);
+        }
+
+        /**
+         * Gets the number of bad link checks in the window.
+         *
+         * @return The number of bad checks.
+         *
+         * @throws None
+         */
+        int badSamples() const
+        {
+            std::uint32_t mask = config_.window >= 32 ? UINT32_MAX : (std::uint32_t(1) << config_.window) - 1;
+            return std::popcount(history_ & mask);
+        }
+
+        /**
+         * Checks if the link has been bad too often within the window.
+         *
+         * @return True if the link is degraded, false otherwise.
+         *
+         * @throws None
+         */
+        bool degraded() const
+        {
+            return degraded_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        RadioMonitorConfig config_;
+        std::uint32_t history_ = 0;
+        std::uint8_t ticks_ = 0;
+        std::atomic<bool> degraded_{false};
+    };
+
+    /**
+     * How the watchdog's sample period follows robot activity.
+     */
+    struct AdaptivePollConfig
+    {
+        std::uint32_t min_ms = 10;             ///< Sample period while the robot is active.
+        std::uint32_t max_ms = 160;            ///< Longest sample period once the robot has been quiet for a while.
+        std::uint32_t hold_ms = 250;           ///< How long to keep sampling at `min_ms` after the last activity.
+        PortMask current_ports;                ///< Motors whose current draw counts as activity.
+        std::int32_t current_limit_ma = 1500;  ///< Current draw above which a motor counts as active.
+        std::uint8_t imu_port = 0;             ///< IMU used to detect collisions, or 0 for none.
+        double accel_limit_g = 0.5;            ///< Change in acceleration between two samples that counts as a collision.
+    };
+
+    /**
+     * Chooses the next sample period from how active the robot is.
+     *
+     * Any activity drops the period to `min_ms`. Activity includes a reported event, a change still being
+     * debounced, a motor in `current_ports` drawing more than `current_limit_ma`, or an IMU acceleration jump
+     * above `accel_limit_g`. After `hold_ms` without activity the period doubles on every quiet sample until it
+     * reaches `max_ms`. The worst-case detection latency is therefore `max_ms` while quiet and `min_ms` while active.
+     */
+    class AdaptivePoller
+    {
+    public:
+        /**
+         * Creates a poller that starts at the fast rate.
+         *
+         * @param config The bounds and activity thresholds.
+         */
+        explicit AdaptivePoller(AdaptivePollConfig config = {})
+        {
+            configure(config);
+        }
+
+        /**
+         * Sets the bounds and activity thresholds and returns to the fast rate.
+         *
+         * @param config The bounds and activity thresholds.
+         *
+         * @throws None
+         */
+        void configure(AdaptivePollConfig config)
+        {
+            config_ = config;
+            if (config_.min_ms == 0)
+                config_.min_ms = 1;
+            if (config_.max_ms < config_.min_ms)
+                config_.max_ms = config_.min_ms;
+            period_ = config_.min_ms;
+            have_accel_ = false;
+            last_active_ = pros::millis();
+        }
+
+        /**
+         * Reads the motor current and IMU sensors and checks them against the activity thresholds.
+         *
+         * Only motors and the IMU that the snapshot shows as plugged in are read, so an unplugged sensor does not
+         * count as activity.
+         *
+         * @param snapshot The watchdog's latest snapshot.
+         *
+         * @return True if a sensor shows the robot is active, false otherwise.
+         *
+         * @throws None
+         */
+        bool sense(const PortSnapshot &snapshot)
+        {
+            bool active = false;
+            for (int port : config_.current_ports & snapshot.ofType(pros::v5::DeviceType::motor))
+            {
+                std::int32_t current = pros::c::motor_get_current_draw(static_cast<std::int8_t>(port));
+                if (current != PROS_ERR && current > config_.current_limit_ma)
+                {
+                    active = true;
+                    break;
+                }
+            }
+
+            if (config_.imu_port == 0 || snapshot.type(config_.imu_port) != pros::v5::DeviceType::imu)
+            {
+                have_accel_ = false;
+                return active;
+            }
+            pros::c::imu_accel_s_t accel = pros::c::imu_get_accel(config_.imu_port);
+            if (accel.x == PROS_ERR_F)
+            {
+                have_accel_ = false;
+                return active;
+            }
+            if (have_accel_)
+            {
+                double dx = accel.x - accel_[0];
+                double dy = accel.y - accel_[1];
+                double dz = accel.z - accel_[2];
+                if (dx * dx + dy * dy + dz * dz > config_.accel_limit_g * config_.accel_limit_g)
+                    active = true;
+            }
+            accel_ = {accel.x, accel.y, accel.z};
+            have_accel_ = true;
+            return active;
+        }
+
+        /**
+         * Chooses the period until the next sample.
+         *
+         * @param active Whether this sample saw activity.
+         * @param now The time of the sample in milliseconds.
+         *
+         * @return The next sample period in milliseconds.
+         *
+         * @throws None
+         */
+        std::uint32_t next(bool active, std::uint32_t now)
+        {
+            if (active)
+            {
+                last_active_ = now;
+                period_ = config_.min_ms;
+            }
+            else if (now - last_active_ >= config_.hold_ms)
+            {
+                period_ = period_ >= config_.max_ms / 2 ? config_.max_ms : period_ * 2;
+            }
+            return period_;
+        }
+
+        /**
+         * Gets the bounds and activity thresholds.
+         *
+         * @return The configuration.
+         *
+         * @throws None
+         */
+        const AdaptivePollConfig &config() const
+        {
+            return config_;
+        }
+
+    private:
+        AdaptivePollConfig config_;
+        std::uint32_t period_ = 0;
+        std::uint32_t last_active_ = 0;
+        std::array<double, 3> accel_{};
+        bool have_accel_ = false;
+    };
+
+    /**
+     * Gets the filter bit for one kind of port event.
+     *
+     * @param kind The kind of event.
+     *
+     * @return The bit to pass to `EventBus::subscribe`.
+     *
+     * @throws None
+     */
+    constexpr std::uint8_t eventBit(PortEventKind kind)
+    {
+        return static_cast<std::uint8_t>(1u << static_cast<std::uint8_t>(kind));
+    }
+
+    /**
+     * The filter that accepts every kind of port event.
+     */
+    inline constexpr std::uint8_t ALL_PORT_EVENTS =
+        eventBit(PortEventKind::plugged) | eventBit(PortEventKind::unplugged) | eventBit(PortEventKind::changed);
+
+    /**
+     * Blocks the calling background task until its owner removes it. Call it as the last step of a task function,
+     * after telling the owner the work is done, so the owner never has to race a task that already exited and
+     * always removes one that is parked holding nothing.
+     *
+     * @throws None
+     */
+    inline void parkUntilRemoved()
+    {
+        while (true)
+            pros::Task::notify_take(true, TIMEOUT_MAX);
+    }
+
+    /**
+     * Stops a background task that checks a stop flag, without ever removing it in the middle of its work.
+     *
+     * Sets `stopping`, wakes the task, and waits until it sets `finished` and parks, so it is never removed while
+     * it holds a device's port mutex or is halfway through a file write. The wait gives up if the task is
+     * suspended or already gone, since it could then never finish. The task is removed and reset afterwards.
+     *
+     * @param task The task to stop. Reset when this returns.
+     * @param stopping The flag the task checks between units of work.
+     * @param finished The flag the task sets before it parks.
+     *
+     * @throws None
+     */
+    inline void stopTask(std::optional<pros::Task> &task, std::atomic<bool> &stopping,
+                         const std::atomic<bool> &finished)
+    {
+        if (!task)
+            return;
+        stopping.store(true, std::memory_order_release);
+        task->notify();
+        while (!finished.load(std::memory_order_acquire))
+        {
+            std::uint32_t state = task->get_state();
+            if (state == pros::E_TASK_STATE_SUSPENDED || state == pros::E_TASK_STATE_DELETED ||
+                state == pros::E_TASK_STATE_INVALID)
+                break;
+            pros::delay(1);
+        }
+        task->remove();
+        task.reset();
+    }
+
+    /**
+     * Lets a producer on one task wake a background task that another task may stop at any time.
+     *
+     * `notify` only reaches the task while it is published, and `withdraw` waits for a `notify` that is already
+     * running to return, so the task is never notified through a handle that `stopTask` has removed. Calls that
+     * start after the withdrawal see no task, so a busy producer cannot hold `withdraw` up. Publish the task after
+     * starting it and withdraw it before stopping it.
+     */
+    class TaskNotifier
+    {
+    public:
+        /**
+         * Makes a started task reachable by `notify`.
+         *
+         * @param task The task to wake. It must stay valid until `withdraw` returns.
+         *
+         * @throws None
+         */
+        void publish(pros::Task &task)
+        {
+            target_.store(&task);
+        }
+
+        /**
+         * Wakes the published task, if any. Call this from a single producer task.
+         *
+         * @throws None
+         */
+        void notify()
+        {
+            // Sequentially consistent on both sides: either withdraw counts this call as begun, or this call sees
+            // the cleared target.
+            begun_.fetch_add(1);
+            if (pros::Task *task = target_.load())
+                task->notify();
+            done_.fetch_add(1);
+        }
+
+        /**
+         * Makes the task unreachable and waits for any `notify` that may still be using it.
+         *
+         * @throws None
+         */
+        void withdraw()
+        {
+            target_.store(nullptr);
+            std::uint32_t begun = begun_.load();
+            while (static_cast<std::int32_t>(done_.load() - begun) < 0)
+                pros::delay(1);
+        }
+
+    private:
+        std::atomic<pros::Task *> target_{nullptr};
+        std::atomic<std::uint32_t> begun_{0};
+        std::atomic<std::uint32_t> done_{0};
+    };
+
+    /**
+     * Delivers port events to registered callbacks from a dedicated dispatcher task.
+     *
+     * The publisher, usually the watchdog task, only pushes the event into a bounded `SpscRing` and wakes the
+     * dispatcher, so a slow callback such as an SD card write never stretches the sampling period. Each
+     * subscriber chooses the ports and event kinds it wants. Callbacks are plain function pointers with a context
+     * argument, so subscribing does not allocate. Subscribe from a single task, normally during `initialize`.
+     */
+    class EventBus
+    {
+    public:
+        /**
+         * The maximum number of subscribers.
+         */
+        static constexpr std::size_t MAX_SUBSCRIBERS = 8;
+
+        /**
+         * The maximum number of events waiting for the dispatcher.
+         */
+        static constexpr std::size_t QUEUE_CAPACITY = 32;
+
+        /**
+         * The function called for every matching event, on the dispatcher task.
+         */
+        using Callback = void (*)(const PortEvent &event, void *arg);
+
+        EventBus() = default;
+        EventBus(const EventBus &) = delete;
+        EventBus &operator=(const EventBus &) = delete;
+
+        ~EventBus()
+        {
+            stop();
+        }
+
+        /**
+         * Registers a callback for some ports and event kinds.
+         *
+         * @param ports The ports to receive events for.
+         * @param kinds The event kinds to receive, built from `eventBit`, or `ALL_PORT_EVENTS`.
+         * @param callback The function to call.
+         * @param arg Passed to `callback`.
+         *
+         * @return An id for `unsubscribe`, or -1 if every slot is taken.
+         *
+         * @throws None
+         */
+        int subscribe(PortMask ports, std::uint8_t kinds, Callback callback, void *arg = nullptr)
+        {
+            for (std::size_t i = 0; i < MAX_SUBSCRIBERS; i++)
+            {
+                Subscriber &subscriber = subscribers_[i];
+                if (subscriber.active.load(std::memory_order_acquire))
+                    continue;
+                subscriber.ports = ports;
+                subscriber.kinds = kinds;
+                subscriber.callback = callback;
+                subscriber.arg = arg;
+                subscriber.active.store(true, std::memory_order_release);
+                return static_cast<int>(i);
+            }
+            return -1;
+        }
+
+        /**
+         * Removes a callback. A call that is already running finishes normally.
+         *
+         * @param id The id returned by `subscribe`.
+         *
+         * @throws None
+         */
+        void unsubscribe(int id)
+        {
+            if (id >= 0 && static_cast<std::size_t>(id) < MAX_SUBSCRIBERS)
+                subscribers_[id].active.store(false, std::memory_order_release);
+        }
+
+        /**
+         * Queues an event for the dispatcher and wakes it. Call this from a single publisher task.
+         *
+         * @param event The event to deliver.
+         *
+         * @return True if the event was queued, false if the queue was full and the event was dropped.
+         *
+         * @throws None
+         */
+        bool publish(const PortEvent &event)
+        {
+            if (!queue_.push(event))
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            notifier_.notify();
+            return true;
+        }
+
+        /**
+         * Delivers every queued event to its subscribers. The dispatcher task calls this; it can also be called
+         * directly while the task is stopped.
+         *
+         * @return The number of events delivered.
+         *
+         * @throws None
+         */
+        std::size_t dispatch()
+        {
+            std::size_t delivered = 0;
+            PortEvent event;
+            while (queue_.pop(event))
+            {
+                for (Subscriber &subscriber : subscribers_)
+                {
+                    if (!subscriber.active.load(std::memory_order_acquire))
+                        continue;
+                    if (subscriber.ports.test(event.port) && (subscriber.kinds & eventBit(event.kind)))
+                        subscriber.callback(event, subscriber.arg);
+                }
+                delivered++;
+            }
+            return delivered;
+        }
+
+        /**
+         * Starts the dispatcher task. Does nothing if it is already running.
+         *
+         * @param priority The priority of the dispatcher task. Keep it below the control loop.
+         *
+         * @throws None
+         */
+        void start(std::uint32_t priority = TASK_PRIORITY_MIN + 1)
+        {
+            if (task_)
+                return;
+            stopping_.store(false, std::memory_order_relaxed);
+            finished_.store(false, std::memory_order_relaxed);
+            task_.emplace(run, this, priority, TASK_STACK_DEPTH_DEFAULT, "safety events");
+            notifier_.publish(*task_);
+        }
+
+        /**
+         * Stops the dispatcher task. Queued events stay queued.
+         *
+         * The task is asked to finish and is only removed once it is parked, so it is never stopped in the middle
+         * of a callback. This waits until the callback that is running, if any, returns. Call it from a single task.
+         *
+         * @throws None
+         */
+        void stop()
+        {
+            notifier_.withdraw();
+            stopTask(task_, stopping_, finished_);
+        }
+
+        /**
+         * Gets the number of events dropped because the queue was full.
+         *
+         * @return The number of dropped events.
+         *
+         * @throws None
+         */
+        std::uint32_t dropped() const
+        {
+            return dropped_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Subscriber
+        {
+            PortMask ports;
+            std::uint8_t kinds = 0;
+            Callback callback = nullptr;
+            void *arg = nullptr;
+            std::atomic<bool> active{false};
+        };
+
+        static void run(void *param)
+        {
+            EventBus *self = static_cast<EventBus *>(param);
+            // Dispatch before every wait, so events queued while the task was stopped or before it was published
+            // are delivered even if their notify was missed.
+            while (!self->stopping_.load(std::memory_order_acquire))
+            {
+                self->dispatch();
+                pros::Task::notify_take(true, TIMEOUT_MAX);
+            }
+            self->finished_.store(true, std::memory_order_release);
+            parkUntilRemoved();
+        }
+
+        std::array<Subscriber, MAX_SUBSCRIBERS> subscribers_;
+        SpscRing<PortEvent, QUEUE_CAPACITY> queue_;
+        std::atomic<std::uint32_t> dropped_{0};
+        std::atomic<bool> stopping_{false};
+        std::atomic<bool> finished_{false};
+        TaskNotifier notifier_;
+        std::optional<pros::Task> task_;
+    };
+
+    /**
+     * The number of scan tiers. Tier `t` is scanned once every `2^t` watchdog samples.
+     */
+    inline constexpr std::uint8_t SCAN_TIER_COUNT = 4;
+
+    /**
+     * Which smart ports the watchdog reads on each sample, so critical devices are checked more often.
+     *
+     * Tier 0 ports are read on every sample. The ports of a lower tier `t` are spread round-robin over `2^t`
+     * consecutive samples, so each of them is read once every `2^t` samples and the reads are spread evenly
+     * across ticks. The due ports for all `CYCLE` ticks are precomputed as masks, so `due` is a single array read.
+     * By default every port is in tier 0, which reads every port on every sample.
+     */
+    class ScanSchedule
+    {
+    public:
+        /**
+         * The number of samples after which the schedule repeats.
+         */
+        static constexpr std::size_t CYCLE = std::size_t(1) << (SCAN_TIER_COUNT - 1);
+
+        /**
+         * Creates a schedule with every port in tier 0.
+         */
+        constexpr ScanSchedule()
+        {
+            tiers_.fill(0);
+            rebuild();
+        }
+
+        /**
+         * Moves a port to a tier. Tiers above the lowest are clamped to `SCAN_TIER_COUNT - 1`.
+         *
+         * @param port The port number, from 1 to 21.
+         * @param tier The tier, where 0 is scanned most often.
+         *
+         * @return True if the port was in range, false otherwise.
+         *
+         * @throws None
+         */
+        constexpr bool assign(int port, std::uint8_t tier)
+        {
+            if (port < 0)
+                port = -port;
+            if (port < 1 || port > SMART_PORT_COUNT)
+                return false;
+            tiers_[port - 1] = tier < SCAN_TIER_COUNT ? tier : SCAN_TIER_COUNT - 1;
+            rebuild();
+            return true;
+        }
+
+        /**
+         * Moves several ports to a tier.
+         *
+         * @param ports The ports to move.
+         * @param tier The tier, where 0 is scanned most often.
+         *
+         * @throws None
+         */
+        constexpr void assign(PortMask ports, std::uint8_t tier)
+        {
+            for (int port : ports)
+                tiers_[port - 1] = tier < SCAN_TIER_COUNT ? tier : SCAN_TIER_COUNT - 1;
+            rebuild();
+        }
+
+        /**
+         * Gets the tier of a port.
+         *
+         * @param port The port number, from 1 to 21.
+         *
+         * @return The tier, or the lowest tier if the port is out of range.
+         *
+         * @throws None
+         */
+        constexpr std::uint8_t tier(int port) const
+        {
+            if (port < 0)
+                port = -port;
+            if (port < 1 || port > SMART_PORT_COUNT)
+                return SCAN_TIER_COUNT - 1;
+            return tiers_[port - 1];
+        }
+
+        /**
+         * Gets the ports to read on a sample.
+         *
+         * @param tick The number of the sample, counting up from any start.
+         *
+         * @return A mask of the ports that are due.
+         *
+         * @throws None
+         */
+        constexpr PortMask due(std::uint32_t tick) const
+        {
+            return due_[tick % CYCLE];
+        }
+
+        /**
+         * Gets the number of samples between two reads of a port, which bounds how long a change goes unseen.
+         *
+         * @param port The port number, from 1 to 21.
+         *
+         * @return The number of samples between reads.
+         *
+         * @throws None
+         */
+        constexpr std::uint32_t interval(int port) const
+        {
+            return std::uint32_t(1) << tier(port);
+        }
+
+    private:
+        constexpr void rebuild()
+        {
+            std::array<std::uint8_t, SCAN_TIER_COUNT> rank{};
+            due_.fill(PortMask());
+            for (int port = 1; port <= SMART_PORT_COUNT; port++)
+            {
+                std::uint8_t tier = tiers_[port - 1];
+                std::size_t stride = std::size_t(1) << tier;
+                for (std::size_t tick = rank[tier]++ % stride; tick < CYCLE; tick += stride)
+                    due_[tick].set(port);
+            }
+        }
+
+        std::array<std::uint8_t, SMART_PORT_COUNT> tiers_{};
+        std::array<PortMask, CYCLE> due_{};
+    };
+
+    /**
+     * The part of a match the robot is in, as reported by the field or competition switch.
+     */
+    enum class MatchPhase : std::uint8_t
+    {
+        practice,   ///< No field or competition switch is connected, so the robot runs freely.
+        disabled,   ///< Connected and disabled, for example before the match or between periods.
+        autonomous, ///< Connected and running the autonomous period.
+        opcontrol   ///< Connected and running the driver control period.
+    };
+
+    /**
+     * Reads the current match phase. This is a single read of the competition status.
+     *
+     * @return The match phase.
+     *
+     * @throws None
+     */
+    inline MatchPhase matchPhase()
+    {
+        std::uint8_t status = pros::c::competition_get_status();
+        if (!(status & COMPETITION_CONNECTED))
+            return MatchPhase::practice;
+        if (status & COMPETITION_DISABLED)
+            return MatchPhase::disabled;
+        return (status & COMPETITION_AUTONOMOUS) ? MatchPhase::autonomous : MatchPhase::opcontrol;
+    }
+
+    /**
+     * Checks if a phase is part of a running match, where the safety layer should only do cheap work.
+     *
+     * @param phase The phase to check.
+     *
+     * @return True for `autonomous` and `opcontrol`, false for `practice` and `disabled`.
+     *
+     * @throws None
+     */
+    constexpr bool isActivePhase(MatchPhase phase)
+    {
+        return phase == MatchPhase::autonomous || phase == MatchPhase::opcontrol;
+    }
+
+    /**
+     * Converts a `MatchPhase` to its name.
+     *
+     * @param phase The phase to convert.
+     *
+     * @return "practice", "disabled", "autonomous", "opcontrol", or "unknown" for any other value.
+     *
+     * @throws None
+     */
+    constexpr const char *matchPhase_to_string(MatchPhase phase)
+    {
+        switch (phase)
+        {
+        case MatchPhase::practice:
+            return "practice";
+        case MatchPhase::disabled:
+            return "disabled";
+        case MatchPhase::autonomous:
+            return "autonomous";
+        case MatchPhase::opcontrol:
+            return "opcontrol";
+        }
+        return "unknown";
+    }
+
+    /**
+     * Watches every smart port from a low-priority task and reports plug, unplug, and type-change events.
+     *
+     * Each sample refreshes a `PortSnapshot` and runs it through a `PortDebouncer`. Only ports whose stable type
+     * changed produce an event, which is pushed into a fixed-capacity `SpscRing`. The control loop drains events
+     * with `poll` without allocating or taking a mutex. If the ring is full, new events are dropped and counted. A
+     * `ScanSchedule` can read less important ports on fewer samples. The sample period is fixed unless
+     * `enableAdaptivePolling` lets an `AdaptivePoller` stretch it while the robot is quiet.
+     */
+    class Watchdog
+    {
+    public:
+        /**
+         * The maximum number of undrained events.
+         */
+        static constexpr std::size_t EVENT_CAPACITY = 32;
+
+        /**
+         * Creates a stopped watchdog.
+         *
+         * @param period_ms The time between samples in milliseconds.
+         * @param debounce How long a change must persist before it is reported. The default reports every change.
+         */
+        explicit Watchdog(std::uint32_t period_ms = 20, DebounceConfig debounce = {})
+            : period_(period_ms), fixed_period_(period_ms), debouncer_(debounce)
+        {
+        }
+
+        Watchdog(const Watchdog &) = delete;
+        Watchdog &operator=(const Watchdog &) = delete;
+
+        ~Watchdog()
+        {
+            stop();
+        }
+
+        /**
+         * Takes a baseline sample and starts the watchdog task. Does nothing if the task is already running.
+         *
+         * @param priority The priority of the watchdog task.
+         *
+         * @throws None
+         */
+        void start(std::uint32_t priority = TASK_PRIORITY_MIN + 1)
+        {
+            if (task_)
+                return;
+            current_.refresh();
+            debouncer_.reset(current_);
+            shared_.publish(current_);
+            stopping_.store(false, std::memory_order_relaxed);
+            finished_.store(false, std::memory_order_relaxed);
+            task_.emplace(run, this, priority, TASK_STACK_DEPTH_DEFAULT, "safety watchdog");
+        }
+
+        /**
+         * Stops the watchdog task. Events that are still queued can be drained with `poll`.
+         *
+         * The task is asked to finish and is only removed once it is parked, so it is never stopped in the middle
+         * of a sample while it holds a device's port mutex. This waits for the sample that is running, if any.
+         * Call it from a single task.
+         *
+         * @throws None
+         */
+        void stop()
+        {
+            stopTask(task_, stopping_, finished_);
+        }
+
+        /**
+         * Checks if the watchdog task is running.
+         *
+         * @return True if the task is running, false otherwise.
+         *
+         * @throws None
+         */
+        bool running() const
+        {
+            return task_.has_value();
+        }
+
+        /**
+         * Reads the ports that are due and queues an event for each port whose stable type changed. Ports with a
+         * change that is still being debounced are read on every sample regardless of their tier.
+         *
+         * The watchdog task calls this every period. It can also be called directly while the task is stopped,
+         * but never from two tasks at once.
+         *
+         * @throws None
+         */
+        void sample()
+        {
+            SAFETY_PROFILE(watchdogSample);
+            const ScanSchedule &schedule = match_aware_ && isActivePhase(matchPhase()) ? match_schedule_ : schedule_;
+            PortMask due = schedule.due(tick_++) | debouncer_.pending();
+            current_.refresh(due);
+            std::uint32_t now = current_.timestamp();
+            bool changed = false;
+            for (int port : due)
+            {
+                pros::v5::DeviceType before = debouncer_.stable(port);
+                if (!debouncer_.update(port, current_.type(port), now))
+                    continue;
+                pros::v5::DeviceType after = debouncer_.stable(port);
+
+                bool was_plugged = !(before == pros::v5::DeviceType::none || before == pros::v5::DeviceType::undefined);
+                bool is_plugged = !(after == pros::v5::DeviceType::none || after == pros::v5::DeviceType::undefined);
+                if (!was_plugged && !is_plugged)
+                    continue;
+
+                PortEventKind kind = !was_plugged  ? PortEventKind::plugged
+                                     : !is_plugged ? PortEventKind::unplugged
+                                                   : PortEventKind::changed;
+                PortEvent event{now, static_cast<std::uint8_t>(port), kind, before, after};
+                changed = true;
+                if (!events_.push(event))
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                if (EventBus *bus = bus_.load(std::memory_order_acquire))
+                    bus->publish(event);
+            }
+
+            shared_.publish(current_);
+            if (radio_enabled_)
+                radio_.tick(current_);
+
+            if (adaptive_)
+            {
+                // Sense on every sample, even when already active, so the acceleration baseline stays current.
+                bool sensed = poller_.sense(current_);
+                bool active = changed || debouncer_.pending().any() || sensed;
+                period_.store(poller_.next(active, now), std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * Sets how long a change must persist before it is reported. Call this while the task is stopped.
+         *
+         * @param debounce The hysteresis to apply.
+         *
+         * @throws None
+         */
+        void setDebounce(DebounceConfig debounce)
+        {
+            debouncer_.configure(debounce);
+        }
+
+        /**
+         * Sets how often each port is read, usually from `Manifest::schedule`. Call this while the task is stopped.
+         *
+         * A change on a port of tier `t` is seen within `2^t` samples, plus the debounce time.
+         *
+         * @param schedule The scan tier of every port.
+         *
+         * @throws None
+         */
+        void setSchedule(const ScanSchedule &schedule)
+        {
+            schedule_ = schedule;
+            tick_ = 0;
+        }
+
+        /**
+         * Uses a different, usually sparser, schedule during the autonomous and driver periods of a match, so the
+         * full scan set by `setSchedule` only runs while disabled or practicing. The watchdog then reads the
+         * competition status once per sample. Call this while the task is stopped.
+         *
+         * @param schedule The scan tier of every port during a match.
+         *
+         * @throws None
+         */
+        void setMatchSchedule(const ScanSchedule &schedule)
+        {
+            match_schedule_ = schedule;
+            match_aware_ = true;
+        }
+
+        /**
+         * Goes back to using the `setSchedule` schedule in every phase. Call this while the task is stopped.
+         *
+         * @throws None
+         */
+        void clearMatchSchedule()
+        {
+            match_aware_ = false;
+        }
+
+        /**
+         * Takes the oldest queued event. Call this from a single consumer task, usually the control loop.
+         *
+         * @param event Receives the event.
+         *
+         * @return True if an event was taken, false if none were queued.
+         *
+         * @throws None
+         */
+        bool poll(PortEvent &event)
+        {
+            return events_.pop(event);
+        }
+
+        /**
+         * Gets the number of events dropped because the queue was full.
+         *
+         * @return The number of dropped events.
+         *
+         * @throws None
+         */
+        std::uint32_t dropped() const
+        {
+            return dropped_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Copies the port types from the latest sample. Safe to call from any task while the watchdog runs, and
+         * never blocks the watchdog. The types are raw readings; events report the debounced changes.
+         *
+         * @return A consistent copy of every port.
+         *
+         * @throws None
+         */
+        PortSnapshot snapshot() const
+        {
+            return shared_.read();
+        }
+
+        /**
+         * Gets the shared snapshot the watchdog publishes after every sample, for readers that want to check
+         * `SharedSnapshot::version` before copying.
+         *
+         * @return The shared snapshot.
+         *
+         * @throws None
+         */
+        const SharedSnapshot &shared() const
+        {
+            return shared_;
+        }
+
+        /**
+         * Gets the time between samples.
+         *
+         * @return The sample period in milliseconds.
+         *
+         * @throws None
+         */
+        std::uint32_t period() const
+        {
+            return period_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Sets the time between samples. Takes effect after the next sample. While adaptive polling is enabled, the
+         * period is only used once it is disabled again.
+         *
+         * @param period_ms The sample period in milliseconds.
+         *
+         * @throws None
+         */
+        void setPeriod(std::uint32_t period_ms)
+        {
+            fixed_period_.store(period_ms, std::memory_order_relaxed);
+            if (!adaptive_)
+                period_.store(period_ms, std::memory_order_relaxed);
+        }
+
+        /**
+         * Lets the sample period follow robot activity instead of staying fixed. Call this while the task is
+         * stopped.
+         *
+         * The radio monitor still counts samples, so its link checks also slow down while the robot is quiet.
+         *
+         * @param config The period bounds and activity thresholds.
+         *
+         * @throws None
+         */
+        void enableAdaptivePolling(AdaptivePollConfig config = {})
+        {
+            poller_.configure(config);
+            adaptive_ = true;
+            period_.store(poller_.config().min_ms, std::memory_order_relaxed);
+        }
+
+        /**
+         * Returns to the fixed sample period set by the constructor or `setPeriod`. Call this while the task is
+         * stopped.
+         *
+         * @throws None
+         */
+        void disableAdaptivePolling()
+        {
+            adaptive_ = false;
+            period_.store(fixed_period_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+
+        /**
+         * Checks if the sample period follows robot activity.
+         *
+         * @return True if adaptive polling is enabled, false otherwise.
+         *
+         * @throws None
+         */
+        bool adaptive() const
+        {
+            return adaptive_;
+        }
+
+        /**
+         * Publishes every event to a bus as well as queueing it for `poll`. The bus must outlive the watchdog or be
+         * detached first. If nothing polls the watchdog, its own queue fills up and further events are only counted
+         * by `dropped`, which does not affect the bus.
+         *
+         * @param bus The bus to publish to, or null to detach.
+         *
+         * @throws None
+         */
+        void attach(EventBus *bus)
+        {
+            bus_.store(bus, std::memory_order_release);
+        }
+
+        /**
+         * Starts checking the radio link every few samples. Call this while the task is stopped.
+         *
+         * @param config How to sample the link.
+         *
+         * @throws None
+         */
+        void enableRadioMonitor(RadioMonitorConfig config = {})
+        {
+            radio_.configure(config);
+            radio_enabled_ = true;
+        }
+
+        /**
+         * Stops checking the radio link. Call this while the task is stopped.
+         *
+         * @throws None
+         */
+        void disableRadioMonitor()
+        {
+            radio_enabled_ = false;
+            radio_.configure(RadioMonitorConfig());
+        }
+
+        /**
+         * Checks if the radio monitor considers the link degraded. Safe to call from any task.
+         *
+         * @return True if the link is degraded, false otherwise or if the radio monitor is disabled.
+         *
+         * @throws None
+         */
+        bool linkDegraded() const
+        {
+            return radio_.degraded();
+        }
+
+    private:
+        static void run(void *param)
+        {
+            Watchdog *self = static_cast<Watchdog *>(param);
+            std::uint32_t wake = pros::millis();
+            while (!self->stopping_.load(std::memory_order_acquire))
+            {
+                self->sample();
+                // Sleeps like delay_until, but a notify from stop() ends the wait early.
+                wake += self->period();
+                std::int32_t remaining = static_cast<std::int32_t>(wake - pros::millis());
+                if (remaining > 0)
+                    pros::Task::notify_take(true, static_cast<std::uint32_t>(remaining));
+                else
+                    wake = pros::millis();
+            }
+            self->finished_.store(true, std::memory_order_release);
+            parkUntilRemoved();
+        }
+
+        std::atomic<std::uint32_t> period_;
+        std::atomic<std::uint32_t> fixed_period_;
+        std::atomic<std::uint32_t> dropped_{0};
+        PortSnapshot current_;
+        SharedSnapshot shared_;
+        PortDebouncer debouncer_;
+        RadioMonitor radio_;
+        bool radio_enabled_ = false;
+        AdaptivePoller poller_;
+        bool adaptive_ = false;
+        ScanSchedule schedule_;
+        ScanSchedule match_schedule_;
+        bool match_aware_ = false;
+        std::uint32_t tick_ = 0;
+        std::atomic<EventBus *> bus_{nullptr};
+        SpscRing<PortEvent, EVENT_CAPACITY> events_;
+        std::atomic<bool> stopping_{false};
+        std::atomic<bool> finished_{false};
+        std::optional<pros::Task> task_;
+    };
+
+    /**
+     * Turns watchdog events into controller alerts without flooding the controller link.
+     *
+     * The controller accepts roughly one `set_text` or `rumble` every 50 ms. Events are coalesced into a mask of
+     * lost ports, and `update` sends at most one message per slot: a rumble when a critical port is newly lost,
+     * otherwise a text line listing the lost ports with critical ports first. Every call returns immediately, so
+     * the sink can be updated from the control loop. All methods must be called from the same task.
+     */
+    class AlertSink
+    {
+    public:
+        /**
+         * The shortest time the controller needs between two messages.
+         */
+        static constexpr std::uint32_t CONTROLLER_SLOT_MS = 50;
+
+        /**
+         * Creates a sink with nothing lost.
+         *
+         * @param critical The ports whose loss should rumble the controller and be listed first.
+         * @param line The controller screen line to write alerts on, from 0 to 2.
+         * @param slot_ms The minimum time between two controller messages.
+         */
+        explicit AlertSink(PortMask critical = PortMask(), std::uint8_t line = 0,
+                           std::uint32_t slot_ms = CONTROLLER_SLOT_MS)
+            : critical_(critical), line_(line), slot_ms_(slot_ms)
+        {
+        }
+
+        /**
+         * Sets the ports whose loss should rumble the controller and be listed first.
+         *
+         * @param critical The critical ports.
+         *
+         * @throws None
+         */
+        void setCritical(PortMask critical)
+        {
+            critical_ = critical;
+        }
+
+        /**
+         * Records a watchdog event. A port is lost while it is unplugged or holds a different type of device than
+         * it did before, and it is restored only once it holds the type it was lost from again. A critical port
+         * that is restored before its rumble was sent no longer rumbles.
+         *
+         * @param event The event to record. Events for ports outside 1 to 21 are ignored.
+         *
+         * @throws None
+         */
+        void push(const PortEvent &event)
+        {
+            if (event.port < 1 || event.port > SMART_PORT_COUNT)
+                return;
+            if (lost_.test(event.port))
+            {
+                if (event.current != static_cast<pros::v5::DeviceType>(expected_[event.port - 1]))
+                    return;
+                lost_.reset(event.port);
+                rumble_.reset(event.port);
+            }
+            else
+            {
+                if (event.kind == PortEventKind::plugged)
+                    return;
+                lost_.set(event.port);
+                expected_[event.port - 1] = static_cast<std::uint8_t>(event.previous);
+                if (critical_.test(event.port))
+                    rumble_.set(event.port);
+            }
+            text_dirty_ = true;
+        }
+
+        /**
+         * Records every event queued by a watchdog. The sink becomes the watchdog's only consumer.
+         *
+         * @param watchdog The watchdog to drain.
+         *
+         * @throws None
+         */
+        void drain(Watchdog &watchdog)
+        {
+            PortEvent event;
+            while (watchdog.poll(event))
+                push(event);
+        }
+
+        /**
+         * Sends the most important pending alert if a controller slot is free.
+         *
+         * @param controller The controller to alert.
+         *
+         * @return True if a message was sent, false if nothing was pending or the slot was not free yet.
+         *
+         * @throws None
+         */
+        bool update(pros::Controller &controller)
+        {
+            if (rumble_.empty() && !text_dirty_)
+                return false;
+            std::uint32_t now = pros::millis();
+            if (sent_ && now - last_sent_ < slot_ms_)
+                return false;
+
+            if (rumble_.any())
+            {
+                controller.rumble(".");
+                rumble_ = PortMask();
+            }
+            else
+            {
+                char text[20];
+                format(text);
+                controller.set_text(line_, 0, text);
+                text_dirty_ = false;
+            }
+            last_sent_ = now;
+            sent_ = true;
+            return true;
+        }
+
+        /**
+         * Writes the alert line for the current state, padded so it overwrites the previous one.
+         *
+         * @param out The buffer to write into.
+         *
+         * @return The length the text would have without truncation.
+         *
+         * @throws None
+         */
+        std::size_t format(std::span<char> out) const
+        {
+            TextWriter writer(out);
+            if (lost_.empty())
+            {
+                writer.append("DEVICES OK");
+            }
+            else
+            {
+                writer.append("LOST");
+                for (int port : lost_ & critical_)
+                    writer.append(' ').append(std::uint32_t(port));
+                for (int port : lost_ & ~critical_)
+                    writer.append(' ').append(std::uint32_t(port));
+            }
+            while (writer.length() + 1 < out.size())
+                writer.append(' ');
+            return writer.length();
+        }
+
+        /**
+         * Gets the ports that are currently lost.
+         *
+         * @return A mask of the lost ports.
+         *
+         * @throws None
+         */
+        PortMask lost() const
+        {
+            return lost_;
+        }
+
+        /**
+         * Checks if an alert is waiting for a controller slot.
+         *
+         * @return True if a message is pending, false otherwise.
+         *
+         * @throws None
+         */
+        bool pending() const
+        {
+            return rumble_.any() || text_dirty_;
+        }
+
+    private:
+        PortMask critical_;
+        PortMask lost_;
+        PortMask rumble_;
+        std::array<std::uint8_t, SMART_PORT_COUNT> expected_{};
+        std::uint8_t line_;
+        std::uint32_t slot_ms_;
+        std::uint32_t last_sent_ = 0;
+        bool sent_ = false;
+        bool text_dirty_ = false;
+    };
+
+    /**
+     * The thresholds `MotorHealth` uses to flag a motor.
+     */
+    struct MotorHealthLimits
+    {
+        double max_temperature_c = 55.0;    ///< Temperature at or above which a motor is flagged as hot.
+        std::int32_t max_current_ma = 2300; ///< Current draw at or above which a motor is flagged.
+    };
+
+    /**
+     * Samples the temperature, current draw, and kernel fault flags of every motor in a MotorGroup.
+     *
+     * `sample` reads each port's type once, like `inspectMotorGroup`, and only reads telemetry from the ports that
+     * hold motors, so one call replaces both the presence check and the per-motor getter calls. Readings are kept
+     * in fixed parallel arrays indexed by the motor's position in the group.
+     */
+    class MotorHealth
+    {
+    public:
+        /**
+         * Creates an empty sampler.
+         *
+         * @param limits The thresholds to flag motors against.
+         */
+        explicit MotorHealth(MotorHealthLimits limits = {}) : limits_(limits)
+        {
+        }
+
+        /**
+         * Sets the thresholds to flag motors against.
+         *
+         * @param limits The thresholds.
+         *
+         * @throws None
+         */
+        void setLimits(MotorHealthLimits limits)
+        {
+            limits_ = limits;
+        }
+
+        /**
+         * Reads the presence and telemetry of every motor in the group.
+         *
+         * @param group The MotorGroup to sample.
+         *
+         * @return The presence report for the group, as `inspectMotorGroup` would return it.
+         *
+         * @throws None
+         */
+        MotorGroupReport sample(const pros::v5::MotorGroup &group)
+        {
+            MotorGroupReport report;
+            begin(group);
+            for (std::size_t i = 0; i < count_; i++)
+                read(group, i, readPluggedType(ports_[i]), report);
+            return report;
+        }
+
+        /**
+         * Reads the telemetry of every motor in the group, using a snapshot for presence.
+         *
+         * @param snapshot The snapshot to read port types from.
+         * @param group The MotorGroup to sample.
+         *
+         * @return The presence report for the group, as `inspectMotorGroup` would return it.
+         *
+         * @throws None
+         */
+        MotorGroupReport sample(const PortSnapshot &snapshot, const pros::v5::MotorGroup &group)
+        {
+            MotorGroupReport report;
+            begin(group);
+            for (std::size_t i = 0; i < count_; i++)
+                read(group, i, snapshot.type(ports_[i]), report);
+            return report;
+        }
+
+        /**
+         * Gets the number of motors covered by the last sample.
+         *
+         * @return The size of the sampled group.
+         *
+         * @throws None
+         */
+        std::size_t size() const
+        {
+            return count_;
+        }
+
+        /**
+         * Gets the port of a motor in the last sample.
+         *
+         * @param index The motor's position in the group.
+         *
+         * @return The port number, without the reversed sign.
+         *
+         * @throws None
+         */
+        int port(std::size_t index) const
+        {
+            return ports_[index];
+        }
+
+        /**
+         * Gets the temperature of a motor in the last sample.
+         *
+         * @param index The motor's position in the group.
+         *
+         * @return The temperature in degrees Celsius, or 0 if the port did not hold a motor.
+         *
+         * @throws None
+         */
+        float temperature(std::size_t index) const
+        {
+            return temperature_[index];
+        }
+
+        /**
+         * Gets the current draw of a motor in the last sample.
+         *
+         * @param index The motor's position in the group.
+         *
+         * @return The current in milliamps, or 0 if the port did not hold a motor.
+         *
+         * @throws None
+         */
+        std::int32_t current(std::size_t index) const
+        {
+            return current_[index];
+        }
+
+        /**
+         * Gets the motors that were at or above the temperature limit or had the kernel over-temperature flag set.
+         *
+         * @return A mask of the hot motors' ports.
+         *
+         * @throws None
+         */
+        PortMask hot() const
+        {
+            return hot_;
+        }
+
+        /**
+         * Gets the motors that were at or above the current limit or had the kernel over-current flag set.
+         *
+         * @return A mask of the over-current motors' ports.
+         *
+         * @throws None
+         */
+        PortMask overCurrent() const
+        {
+            return over_current_;
+        }
+
+        /**
+         * Gets every motor that was flagged by the last sample.
+         *
+         * @return A mask of the hot and over-current motors' ports.
+         *
+         * @throws None
+         */
+        PortMask flagged() const
+        {
+            return hot_ | over_current_;
+        }
+
+        /**
+         * Gets the highest temperature seen in the last sample.
+         *
+         * @return The temperature in degrees Celsius, or 0 if no motor was read.
+         *
+         * @throws None
+         */
+        float maxTemperature() const
+        {
+            float hottest = 0;
+            for (std::size_t i = 0; i < count_; i++)
+                hottest = temperature_[i] > hottest ? temperature_[i] : hottest;
+            return hottest;
+        }
+
+    private:
+        void begin(const pros::v5::MotorGroup &group)
+        {
+            int size = group.size();
+            count_ = size < 0 ? 0 : size > SMART_PORT_COUNT ? SMART_PORT_COUNT : static_cast<std::size_t>(size);
+            for (std::size_t i = 0; i < count_; i++)
+                ports_[i] = static_cast<std::uint8_t>(std::abs(group.get_port(i)));
+            hot_ = PortMask();
+            over_current_ = PortMask();
+        }
+
+        void read(const pros::v5::MotorGroup &group, std::size_t i, pros::v5::DeviceType type,
+                  MotorGroupReport &report)
+        {
+            classifyMotorPort(report, ports_[i], type);
+            if (type != pros::v5::DeviceType::motor)
+            {
+                temperature_[i] = 0;
+                current_[i] = 0;
+                return;
+            }
+
+            double temperature = group.get_temperature(i);
+            std::int32_t current = group.get_current_draw(i);
+            temperature_[i] = temperature == PROS_ERR_F ? 0.0f : static_cast<float>(temperature);
+            current_[i] = current == PROS_ERR ? 0 : current;
+            if (temperature_[i] >= limits_.max_temperature_c || group.is_over_temp(i) == 1)
+                hot_.set(ports_[i]);
+            if (current_[i] >= limits_.max_current_ma || group.is_over_current(i) == 1)
+                over_current_.set(ports_[i]);
+        }
+
+        MotorHealthLimits limits_;
+        std::size_t count_ = 0;
+        std::array<std::uint8_t, SMART_PORT_COUNT> ports_{};
+        std::array<float, SMART_PORT_COUNT> temperature_{};
+        std::array<std::int32_t, SMART_PORT_COUNT> current_{};
+        PortMask hot_;
+        PortMask over_current_;
+    };
+
+    /**
+     * The readiness of an IMU port.
+     */
+    enum class ImuStatus : std::uint8_t
+    {
+        missing,     ///< Nothing is plugged into the port.
+        wrongType,   ///< The port holds a device that is not an IMU.
+        calibrating, ///< The IMU is calibrating and its readings are not usable yet.
+        error,       ///< The IMU reported an error.
+        ready        ///< The IMU is calibrated and ready to use.
+    };
+
+    /**
+     * Converts an ImuStatus to its name.
+     *
+     * @param status The status to convert.
+     *
+     * @return The name of the status, such as "calibrating".
+     *
+     * @throws None
+     */
+    constexpr const char *imuStatus_to_string(ImuStatus status)
+    {
+        switch (status)
+        {
+        case ImuStatus::missing:
+            return "missing";
+        case ImuStatus::wrongType:
+            return "wrong type";
+        case ImuStatus::calibrating:
+            return "calibrating";
+        case ImuStatus::error:
+            return "error";
+        case ImuStatus::ready:
+            return "ready";
+        }
+        return "unknown";
+    }
+
+    /**
+     * Combines an already-read port type with the IMU's own status flags.
+     *
+     * @param port The port number of the IMU.
+     * @param type The device type plugged into the port.
+     *
+     * @return The readiness of the IMU. The IMU status is only read if the port holds an IMU.
+     *
+     * @throws None
+     */
+    inline ImuStatus imuStatus(int port, pros::v5::DeviceType type)
+    {
+        if (type == pros::v5::DeviceType::none || type == pros::v5::DeviceType::undefined)
+            return ImuStatus::missing;
+        if (type != pros::v5::DeviceType::imu)
+            return ImuStatus::wrongType;
+
+        pros::c::imu_status_e_t status = pros::c::imu_get_status(port);
+        if (status == pros::c::E_IMU_STATUS_ERROR)
+            return ImuStatus::error;
+        if (status & pros::c::E_IMU_STATUS_CALIBRATING)
+            return ImuStatus::calibrating;
+        return ImuStatus::ready;
+    }
+
+    /**
+     * Checks if the IMU at the given port is plugged in and calibrated, without blocking.
+     *
+     * @param port The port number of the IMU.
+     *
+     * @return The readiness of the IMU.
+     *
+     * @throws None
+     */
+    inline ImuStatus imuStatus(int port)
+    {
+        SAFETY_PROFILE(imuStatus);
+        return imuStatus(port, readPluggedType(port));
+    }
+
+    /**
+     * Checks if the IMU at the given port is calibrated, using a snapshot for its presence.
+     *
+     * @param snapshot The snapshot to read the port type from.
+     * @param port The port number of the IMU.
+     *
+     * @return The readiness of the IMU.
+     *
+     * @throws None
+     */
+    inline ImuStatus imuStatus(const PortSnapshot &snapshot, int port)
+    {
+        return imuStatus(port, snapshot.type(port));
+    }
+
+    /**
+     * A handle to an IMU that may still be calibrating, which can be polled or waited on with a deadline.
+     *
+     * Start calibration with `ImuReady::calibrate`, do the rest of the setup, then call `waitUntil` right before the
+     * IMU is needed:
+     *
+     * @code
+     * safety::ImuReady imu = safety::ImuReady::calibrate(10);
+     * // ... set up odometry, load paths ...
+     * if (imu.waitUntil(start + 3000) != safety::ImuStatus::ready)
+     *     // run the fallback routine
+     * @endcode
+     */
+    class ImuReady
+    {
+    public:
+        /**
+         * How long a freshly reset IMU may take to report that it is calibrating before its status is trusted.
+         */
+        static constexpr std::uint32_t CALIBRATION_START_MS = 200;
+
+        /**
+         * Creates a handle to an IMU without starting calibration.
+         *
+         * @param port The port number of the IMU.
+         */
+        explicit ImuReady(int port) : port_(port)
+        {
+        }
+
+        /**
+         * Starts calibrating the IMU without blocking.
+         *
+         * @param port The port number of the IMU.
+         *
+         * @return A handle to the calibrating IMU.
+         *
+         * @throws None
+         */
+        static ImuReady calibrate(int port)
+        {
+            ImuReady imu(port);
+            if (isImu(port) && pros::c::imu_reset(port) != PROS_ERR)
+            {
+                imu.reset_at_ = pros::millis();
+                imu.awaiting_start_ = true;
+            }
+            return imu;
+        }
+
+        /**
+         * Gets the current readiness of the IMU without blocking.
+         *
+         * Right after `calibrate`, the IMU can briefly report ready before its calibrating flag is raised. The
+         * handle reports calibrating until it has seen the flag or `CALIBRATION_START_MS` has passed.
+         *
+         * @return The readiness of the IMU.
+         *
+         * @throws None
+         */
+        ImuStatus poll()
+        {
+            ImuStatus status = imuStatus(port_);
+            if (!awaiting_start_)
+                return status;
+            if (status == ImuStatus::calibrating || pros::millis() - reset_at_ >= CALIBRATION_START_MS)
+                awaiting_start_ = false;
+            else if (status == ImuStatus::ready)
+                return ImuStatus::calibrating;
+            return status;
+        }
+
+        /**
+         * Checks if the IMU is ready without blocking.
+         *
+         * @return True if the IMU is calibrated, false otherwise.
+         *
+         * @throws None
+         */
+        bool ready()
+        {
+            return poll() == ImuStatus::ready;
+        }
+
+        /**
+         * Waits until the IMU is ready, fails, or the deadline passes.
+         *
+         * @param deadline_ms The value of `pros::millis()` to stop waiting at.
+         * @param poll_ms The time between status checks.
+         *
+         * @return The last status that was read. Anything other than ready means the deadline passed or the IMU
+         * failed.
+         *
+         * @throws None
+         */
+        ImuStatus waitUntil(std::uint32_t deadline_ms, std::uint32_t poll_ms = 10)
+        {
+            while (true)
+            {
+                ImuStatus status = poll();
+                if (status != ImuStatus::calibrating)
+                    return status;
+                std::int32_t remaining = static_cast<std::int32_t>(deadline_ms - pros::millis());
+                if (remaining <= 0)
+                    return status;
+                std::uint32_t wait = static_cast<std::uint32_t>(remaining);
+                pros::delay(wait < poll_ms ? wait : poll_ms);
+            }
+        }
+
+        /**
+         * Waits until the IMU is ready, fails, or the timeout passes.
+         *
+         * @param timeout_ms The longest time to wait, in milliseconds.
+         * @param poll_ms The time between status checks.
+         *
+         * @return The last status that was read.
+         *
+         * @throws None
+         */
+        ImuStatus waitFor(std::uint32_t timeout_ms, std::uint32_t poll_ms = 10)
+        {
+            return waitUntil(pros::millis() + timeout_ms, poll_ms);
+        }
+
+        /**
+         * Gets the port of the IMU.
+         *
+         * @return The port number.
+         *
+         * @throws None
+         */
+        int port() const
+        {
+            return port_;
+        }
+
+    private:
+        int port_;
+        std::uint32_t reset_at_ = 0;
+        bool awaiting_start_ = false;
+    };
+
+    /**
+     * The thresholds `RotationGuard` uses to flag a rotation sensor.
+     */
+    struct RotationGuardLimits
+    {
+        std::uint32_t stale_ms = 100;  ///< Time a reading may stay unchanged while motion is expected.
+        std::int32_t max_jump = 18000; ///< Largest plausible change between two readings, in centidegrees.
+    };
+
+    /**
+     * Detects rotation sensors that stay plugged in but stop updating or report implausible jumps.
+     *
+     * The guard does no device I/O of its own. The odometry task passes in the positions it already reads, and
+     * the guard keeps the last value and the time it last changed for each port in two small arrays. A reading
+     * that equals `PROS_ERR` marks the port stale.
+     *
+     * @code
+     * std::int32_t left = left_rotation.get_position();
+     * guard.observe(left_rotation.get_port(), left, drive_is_moving);
+     * if (guard.faulty().test(left_rotation.get_port()))
+     *     // fall back to motor encoders
+     * @endcode
+     */
+    class RotationGuard
+    {
+    public:
+        /**
+         * Creates a guard that has not seen any readings.
+         *
+         * @param limits The thresholds to flag sensors against.
+         */
+        explicit RotationGuard(RotationGuardLimits limits = {}) : limits_(limits)
+        {
+        }
+
+        /**
+         * Sets the thresholds to flag sensors against.
+         *
+         * @param limits The thresholds.
+         *
+         * @throws None
+         */
+        void setLimits(RotationGuardLimits limits)
+        {
+            limits_ = limits;
+        }
+
+        /**
+         * Records a reading that the caller has already taken.
+         *
+         * @param port The port number of the rotation sensor.
+         * @param position The position read from the sensor, in centidegrees.
+         * @param expect_motion Whether the mechanism is being driven. A sensor is only considered stale while
+         * motion is expected, so a robot sitting still does not trip the guard. There is no default, so every
+         * caller has to say whether motion is commanded.
+         *
+         * @throws None
+         */
+        void observe(int port, std::int32_t position, bool expect_motion)
+        {
+            if (port < 1 || port > SMART_PORT_COUNT)
+                return;
+            int i = port - 1;
+            std::uint32_t now = pros::millis();
+            if (position == PROS_ERR)
+            {
+                stale_.set(port);
+                return;
+            }
+            if (!seen_.test(port))
+            {
+                seen_.set(port);
+                last_value_[i] = position;
+                last_change_[i] = now;
+                return;
+            }
+
+            std::int32_t jump = position - last_value_[i];
+            if (jump > limits_.max_jump || jump < -limits_.max_jump)
+                jumped_.set(port);
+            if (jump != 0 || !expect_motion)
+            {
+                last_change_[i] = now;
+                stale_.reset(port);
+            }
+            else if (now - last_change_[i] >= limits_.stale_ms)
+            {
+                stale_.set(port);
+            }
+            last_value_[i] = position;
+        }
+
+        /**
+         * Gets the sensors that stopped updating while motion was expected, or returned an error.
+         *
+         * @return A mask of the stale sensors' ports.
+         *
+         * @throws None
+         */
+        PortMask stale() const
+        {
+            return stale_;
+        }
+
+        /**
+         * Gets the sensors that reported an implausible jump since the last `clear`.
+         *
+         * @return A mask of the sensors' ports.
+         *
+         * @throws None
+         */
+        PortMask jumped() const
+        {
+            return jumped_;
+        }
+
+        /**
+         * Gets every sensor that is stale or has jumped.
+         *
+         * @return A mask of the faulty sensors' ports.
+         *
+         * @throws None
+         */
+        PortMask faulty() const
+        {
+            return stale_ | jumped_;
+        }
+
+        /**
+         * Forgets the history and flags of the given ports, for example after resetting the sensors.
+         *
+         * @param ports The ports to clear.
+         *
+         * @throws None
+         */
+        void clear(PortMask ports = PortMask::all())
+        {
+            seen_ &= ~ports;
+            stale_ &= ~ports;
+            jumped_ &= ~ports;
+        }
+
+    private:
+        RotationGuardLimits limits_;
+        std::array<std::int32_t, SMART_PORT_COUNT> last_value_{};
+        std::array<std::uint32_t, SMART_PORT_COUNT> last_change_{};
+        PortMask seen_;
+        PortMask stale_;
+        PortMask jumped_;
+    };
+
+    /**
+     * The difference between a manifest and the ports recorded by a snapshot.
+     */
+    struct ManifestDiff
+    {
+        PortMask missing;    ///< Registered ports with nothing plugged in.
+        PortMask wrongType;  ///< Registered ports that hold a different device type.
+        PortMask unexpected; ///< Ports that are not registered but have a device plugged in.
+
+        /**
+         * Checks if every registered port holds its expected device. Unexpected devices do not count.
+         *
+         * @return True if nothing is missing or of the wrong type, false otherwise.
+         *
+         * @throws None
+         */
+        bool ok() const
+        {
+            return missing.empty() && wrongType.empty();
+        }
+
+        /**
+         * Checks if the robot matches the manifest exactly, with no unexpected devices either.
+         *
+         * @return True if every mask is empty, false otherwise.
+         *
+         * @throws None
+         */
+        bool exact() const
+        {
+            return ok() && unexpected.empty();
+        }
+    };
+
+    /**
+     * The device type a robot expects on each smart port, registered once and checked many times.
+     *
+     * The expected types live in a 21-byte array next to a mask of the registered ports. `diff` compares a snapshot
+     * against them in one pass over the ports and reports the result as masks, so it never allocates.
+     *
+     * @code
+     * safety::Manifest robot{{1, pros::v5::DeviceType::motor}, {2, pros::v5::DeviceType::motor},
+     *                        {10, pros::v5::DeviceType::imu}};
+     * safety::ManifestDiff diff = robot.diff(safety::PortSnapshot::capture());
+     * @endcode
+     */
+    class Manifest
+    {
+    public:
+        /**
+         * Creates a manifest with no ports registered.
+         */
+        constexpr Manifest()
+        {
+            types_.fill(static_cast<std::uint8_t>(pros::v5::DeviceType::none));
+        }
+
+        /**
+         * Creates a manifest from a list of expectations. Out of range ports are ignored and later entries for the
+         * same port replace earlier ones.
+         *
+         * @param entries The expected device type of each port.
+         */
+        constexpr Manifest(std::initializer_list<PortExpectation> entries) : Manifest()
+        {
+            for (const PortExpectation &entry : entries)
+            {
+                expect(entry.port, entry.type);
+                setTier(entry.port, entry.tier);
+            }
+        }
+
+        /**
+         * Creates a manifest from a `StaticManifest` that was checked at compile time.
+         *
+         * @tparam Static The `StaticManifest` to copy.
+         *
+         * @return The manifest.
+         *
+         * @throws None
+         */
+        template <typename Static>
+        static constexpr Manifest from()
+        {
+            Manifest manifest;
+            for (const PortExpectation &entry : Static::entries)
+            {
+                manifest.expect(entry.port, entry.type);
+                manifest.setTier(entry.port, entry.tier);
+            }
+            return manifest;
+        }
+
+        /**
+         * Registers the device type expected on a port, replacing any earlier registration. Registering
+         * `pros::v5::DeviceType::none` removes the port.
+         *
+         * @param port The port number, from 1 to 21.
+         * @param type The expected device type.
+         *
+         * @return True if the port was in range, false otherwise.
+         *
+         * @throws None
+         */
+        constexpr bool expect(int port, pros::v5::DeviceType type)
+        {
+            if (port < 0)
+                port = -port;
+            if (port < 1 || port > SMART_PORT_COUNT)
+                return false;
+            types_[port - 1] = static_cast<std::uint8_t>(type);
+            if (type == pros::v5::DeviceType::none)
+                ports_.reset(port);
+            else
+                ports_.set(port);
+            return true;
+        }
+
+        /**
+         * Registers the same expected device type on several ports.
+         *
+         * @param ports The ports to register.
+         * @param type The expected device type.
+         *
+         * @throws None
+         */
+        constexpr void expect(PortMask ports, pros::v5::DeviceType type)
+        {
+            for (int port : ports)
+                expect(port, type);
+        }
+
+        /**
+         * Removes a port from the manifest.
+         *
+         * @param port The port number to remove.
+         *
+         * @throws None
+         */
+        constexpr void remove(int port)
+        {
+            expect(port, pros::v5::DeviceType::none);
+        }
+
+        /**
+         * Gets the device type expected on a port.
+         *
+         * @param port The port number to look up.
+         *
+         * @return The expected type, or `pros::v5::DeviceType::none` if the port is not registered.
+         *
+         * @throws None
+         */
+        constexpr pros::v5::DeviceType expected(int port) const
+        {
+            if (!ports_.test(port))
+                return pros::v5::DeviceType::none;
+            return static_cast<pros::v5::DeviceType>(types_[(port < 0 ? -port : port) - 1]);
+        }
+
+        /**
+         * Gets every registered port.
+         *
+         * @return A mask of the registered ports.
+         *
+         * @throws None
+         */
+        constexpr PortMask ports() const
+        {
+            return ports_;
+        }
+
+        /**
+         * Gets the registered ports that expect a given device type.
+         *
+         * @param type The device type to look for.
+         *
+         * @return A mask of the ports that expect `type`.
+         *
+         * @throws None
+         */
+        constexpr PortMask portsOfType(pros::v5::DeviceType type) const
+        {
+            PortMask mask;
+            for (int port : ports_)
+            {
+                if (types_[port - 1] == static_cast<std::uint8_t>(type))
+                    mask.set(port);
+            }
+            return mask;
+        }
+
+        /**
+         * Sets how often the watchdog should read a port. Ports start in tier 0, which is read on every sample.
+         *
+         * @param port The port number, from 1 to 21.
+         * @param tier The scan tier, from 0 to `SCAN_TIER_COUNT - 1`. Larger values are clamped.
+         *
+         * @return True if the port was in range, false otherwise.
+         *
+         * @throws None
+         */
+        constexpr bool setTier(int port, std::uint8_t tier)
+        {
+            if (port < 0)
+                port = -port;
+            if (port < 1 || port > SMART_PORT_COUNT)
+                return false;
+            tiers_[port - 1] = tier < SCAN_TIER_COUNT ? tier : SCAN_TIER_COUNT - 1;
+            return true;
+        }
+
+        /**
+         * Sets how often the watchdog should read several ports.
+         *
+         * @param ports The ports to change.
+         * @param tier The scan tier, from 0 to `SCAN_TIER_COUNT - 1`. Larger values are clamped.
+         *
+         * @throws None
+         */
+        constexpr void setTier(PortMask ports, std::uint8_t tier)
+        {
+            for (int port : ports)
+                setTier(port, tier);
+        }
+
+        /**
+         * Gets the scan tier of a port.
+         *
+         * @param port The port number to look up.
+         *
+         * @return The tier, or the lowest tier if the port is not registered.
+         *
+         * @throws None
+         */
+        constexpr std::uint8_t tier(int port) const
+        {
+            if (!ports_.test(port))
+                return SCAN_TIER_COUNT - 1;
+            return tiers_[(port < 0 ? -port : port) - 1];
+        }
+
+        /**
+         * Builds a watchdog scan schedule from the tiers of the registered ports. Unregistered ports go in the
+         * lowest tier, so unexpected devices are still noticed eventually.
+         *
+         * @return The schedule to pass to `Watchdog::setSchedule`.
+         *
+         * @throws None
+         */
+        constexpr ScanSchedule schedule() const
+        {
+            std::array<PortMask, SCAN_TIER_COUNT> byTier{};
+            for (int port = 1; port <= SMART_PORT_COUNT; port++)
+                byTier[tier(port)].set(port);
+            ScanSchedule schedule;
+            for (std::uint8_t t = 1; t < SCAN_TIER_COUNT; t++)
+                schedule.assign(byTier[t], t);
+            return schedule;
+        }
+
+        /**
+         * Compares a snapshot against the manifest in one pass over the ports.
+         *
+         * @param snapshot The snapshot to compare.
+         * @param out Overwritten with the difference.
+         *
+         * @throws None
+         */
+        void diff(const PortSnapshot &snapshot, ManifestDiff &out) const
+        {
+            SAFETY_PROFILE(manifestDiff);
+            out = ManifestDiff();
+            for (int port = 1; port <= SMART_PORT_COUNT; port++)
+            {
+                pros::v5::DeviceType actual = snapshot.type(port);
+                bool plugged = !(actual == pros::v5::DeviceType::none || actual == pros::v5::DeviceType::undefined);
+                if (!ports_.test(port))
+                {
+                    if (plugged)
+                        out.unexpected.set(port);
+                }
+                else if (!plugged)
+                {
+                    out.missing.set(port);
+                }
+                else if (static_cast<std::uint8_t>(actual) != types_[port - 1])
+                {
+                    out.wrongType.set(port);
+                }
+            }
+        }
+
+        /**
+         * Compares a snapshot against the manifest in one pass over the ports.
+         *
+         * @param snapshot The snapshot to compare.
+         *
+         * @return The difference.
+         *
+         * @throws None
+         */
+        ManifestDiff diff(const PortSnapshot &snapshot) const
+        {
+            ManifestDiff out;
+            diff(snapshot, out);
+            return out;
+        }
+
+    private:
+        std::array<std::uint8_t, SMART_PORT_COUNT> types_{};
+        std::array<std::uint8_t, SMART_PORT_COUNT> tiers_{};
+        PortMask ports_;
+    };
+
+    /**
+     * The number of 3-wire ports on an ADI expander.
+     */
+    inline constexpr int ADI_PORT_COUNT = 8;
+
+    /**
+     * Converts a 3-wire port name to an index, accepting the same forms as PROS: 1 to 8, 'a' to 'h', or 'A' to 'H'.
+     *
+     * @param adi_port The 3-wire port.
+     *
+     * @return The index from 0 to 7, or -1 if the port is not valid.
+     *
+     * @throws None
+     */
+    constexpr int adiPortIndex(int adi_port)
+    {
+        if (adi_port >= 1 && adi_port <= ADI_PORT_COUNT)
+            return adi_port - 1;
+        if (adi_port >= 'a' && adi_port < 'a' + ADI_PORT_COUNT)
+            return adi_port - 'a';
+        if (adi_port >= 'A' && adi_port < 'A' + ADI_PORT_COUNT)
+            return adi_port - 'A';
+        return -1;
+    }
+
+    /**
+     * A set of smart ports plus the 3-wire ports behind any ADI expanders on them.
+     *
+     * `smart` holds the smart ports, and `adi[port - 1]` holds one bit per 3-wire port of the expander on that
+     * smart port, with bit 0 for port A. The whole set is 25 bytes.
+     */
+    struct ExtendedMask
+    {
+        PortMask smart;                                      ///< The smart ports in the set.
+        std::array<std::uint8_t, SMART_PORT_COUNT> adi{};    ///< The 3-wire ports in the set, per smart port.
+
+        /**
+         * Adds a 3-wire port. Its smart port is not added.
+         *
+         * @param smart_port The smart port of the expander, from 1 to 21.
+         * @param adi_port The 3-wire port, in any form accepted by `adiPortIndex`.
+         *
+         * @return This set.
+         *
+         * @throws None
+         */
+        constexpr ExtendedMask &set(int smart_port, int adi_port)
+        {
+            int index = adiPortIndex(adi_port);
+            if (smart_port >= 1 && smart_port <= SMART_PORT_COUNT && index >= 0)
+                adi[smart_port - 1] |= static_cast<std::uint8_t>(1u << index);
+            return *this;
+        }
+
+        /**
+         * Checks if a 3-wire port is in the set.
+         *
+         * @param smart_port The smart port of the expander, from 1 to 21.
+         * @param adi_port The 3-wire port, in any form accepted by `adiPortIndex`.
+         *
+         * @return True if the port is in the set, false otherwise.
+         *
+         * @throws None
+         */
+        constexpr bool test(int smart_port, int adi_port) const
+        {
+            int index = adiPortIndex(adi_port);
+            if (smart_port < 1 || smart_port > SMART_PORT_COUNT || index < 0)
+                return false;
+            return (adi[smart_port - 1] >> index) & 1;
+        }
+
+        /**
+         * Gets the number of 3-wire ports in the set.
+         *
+         * @return The number of 3-wire ports, not counting smart ports.
+         *
+         * @throws None
+         */
+        constexpr int adiCount() const
+        {
+            int count = 0;
+            for (std::uint8_t bits : adi)
+                count += std::popcount(bits);
+            return count;
+        }
+
+        /**
+         * Checks if the set holds no smart ports and no 3-wire ports.
+         *
+         * @return True if the set is empty, false otherwise.
+         *
+         * @throws None
+         */
+        constexpr bool empty() const
+        {
+            return smart.empty() && adiCount() == 0;
+        }
+    };
+
+    /**
+     * The difference between an `AdiManifest` and the robot.
+     */
+    struct AdiDiff
+    {
+        ExtendedMask missing;       ///< Expanders that are not plugged in, with every 3-wire port registered on them.
+        ExtendedMask misconfigured; ///< 3-wire ports whose configuration differs from the registered one.
+
+        /**
+         * Checks if every expander is present and every 3-wire port is configured as registered.
+         *
+         * @return True if both masks are empty, false otherwise.
+         *
+         * @throws None
+         */
+        constexpr bool ok() const
+        {
+            return missing.empty() && misconfigured.empty();
+        }
+    };
+
+    /**
+     * The 3-wire devices a robot expects behind its ADI expanders.
+     *
+     * The V5 cannot tell whether anything is attached to a 3-wire port, so this checks what it can: that each
+     * expander is plugged into its smart port, and that each registered 3-wire port still has the configuration
+     * the code expects, for example `E_ADI_DIGITAL_OUT` for a solenoid. Expander presence comes from the same
+     * `PortSnapshot` as the main port scan, so adding expanders adds no `get_plugged_type` calls, and the
+     * configuration of an expander's ports is only read when the expander is present.
+     *
+     * @code
+     * safety::AdiManifest adi;
+     * adi.expect(8, 'A', pros::E_ADI_DIGITAL_OUT); // clamp solenoid
+     * adi.expect(8, 'B', pros::E_ADI_DIGITAL_IN);  // limit switch
+     * adi.registerExpanders(robot);
+     * safety::PortSnapshot snapshot = safety::PortSnapshot::capture();
+     * safety::ManifestDiff smart = robot.diff(snapshot);
+     * safety::AdiDiff threeWire = adi.diff(snapshot);
+     * @endcode
+     */
+    class AdiManifest
+    {
+    public:
+        /**
+         * Creates a manifest with no 3-wire ports registered.
+         */
+        constexpr AdiManifest()
+        {
+            for (std::array<std::uint8_t, ADI_PORT_COUNT> &expander : configs_)
+                expander.fill(static_cast<std::uint8_t>(pros::E_ADI_TYPE_UNDEFINED));
+        }
+
+        /**
+         * Registers the configuration expected on a 3-wire port, replacing any earlier registration.
+         *
+         * @param smart_port The smart port of the expander, from 1 to 21.
+         * @param adi_port The 3-wire port, in any form accepted by `adiPortIndex`.
+         * @param config The expected configuration.
+         *
+         * @return True if both ports were valid, false otherwise.
+         *
+         * @throws None
+         */
+        constexpr bool expect(int smart_port, int adi_port, pros::adi_port_config_e_t config)
+        {
+            int index = adiPortIndex(adi_port);
+            if (smart_port < 1 || smart_port > SMART_PORT_COUNT || index < 0)
+                return false;
+            configs_[smart_port - 1][index] = static_cast<std::uint8_t>(config);
+            registered_.set(smart_port, adi_port);
+            registered_.smart.set(smart_port);
+            return true;
+        }
+
+        /**
+         * Removes a 3-wire port. The expander stays registered until its last port is removed.
+         *
+         * @param smart_port The smart port of the expander.
+         * @param adi_port The 3-wire port, in any form accepted by `adiPortIndex`.
+         *
+         * @throws None
+         */
+        constexpr void remove(int smart_port, int adi_port)
+        {
+            int index = adiPortIndex(adi_port);
+            if (smart_port < 1 || smart_port > SMART_PORT_COUNT || index < 0)
+                return;
+            configs_[smart_port - 1][index] = static_cast<std::uint8_t>(pros::E_ADI_TYPE_UNDEFINED);
+            registered_.adi[smart_port - 1] &= static_cast<std::uint8_t>(~(1u << index));
+            if (registered_.adi[smart_port - 1] == 0)
+                registered_.smart.reset(smart_port);
+        }
+
+        /**
+         * Gets every registered expander and 3-wire port.
+         *
+         * @return The registered ports.
+         *
+         * @throws None
+         */
+        constexpr const ExtendedMask &registered() const
+        {
+            return registered_;
+        }
+
+        /**
+         * Gets the smart ports of the registered expanders.
+         *
+         * @return A mask of the expanders' smart ports.
+         *
+         * @throws None
+         */
+        constexpr PortMask expanders() const
+        {
+            return registered_.smart;
+        }
+
+        /**
+         * Gets the configuration expected on a 3-wire port.
+         *
+         * @param smart_port The smart port of the expander.
+         * @param adi_port The 3-wire port, in any form accepted by `adiPortIndex`.
+         *
+         * @return The expected configuration, or `E_ADI_TYPE_UNDEFINED` if the port is not registered.
+         *
+         * @throws None
+         */
+        constexpr pros::adi_port_config_e_t expected(int smart_port, int adi_port) const
+        {
+            if (!registered_.test(smart_port, adi_port))
+                return pros::E_ADI_TYPE_UNDEFINED;
+            return static_cast<pros::adi_port_config_e_t>(configs_[smart_port - 1][adiPortIndex(adi_port)]);
+        }
+
+        /**
+         * Registers every expander as an `adi` device in a smart-port manifest, so the main scan and the
+         * watchdog cover the expanders too.
+         *
+         * @param manifest The manifest to add the expanders to.
+         *
+         * @throws None
+         */
+        constexpr void registerExpanders(Manifest &manifest) const
+        {
+            manifest.expect(registered_.smart, pros::v5::DeviceType::adi);
+        }
+
+        /**
+         * Compares the robot against the manifest, using a snapshot for expander presence.
+         *
+         * An expander that is missing or replaced by another device reports its smart port and all of its
+         * registered 3-wire ports as missing.
+         *
+         * @param snapshot The snapshot to read expander presence from.
+         * @param out Overwritten with the difference.
+         *
+         * @throws None
+         */
+        void diff(const PortSnapshot &snapshot, AdiDiff &out) const
+        {
+            out = AdiDiff();
+            for (int smart_port : registered_.smart)
+            {
+                std::uint8_t expected_ports = registered_.adi[smart_port - 1];
+                if (snapshot.type(smart_port) != pros::v5::DeviceType::adi)
+                {
+                    out.missing.smart.set(smart_port);
+                    out.missing.adi[smart_port - 1] = expected_ports;
+                    continue;
+                }
+                for (int index = 0; index < ADI_PORT_COUNT; index++)
+                {
+                    if (!((expected_ports >> index) & 1))
+                        continue;
+                    pros::adi_port_config_e_t actual = pros::c::ext_adi_port_get_config(
+                        static_cast<std::uint8_t>(smart_port), static_cast<std::uint8_t>(index + 1));
+                    if (static_cast<std::uint8_t>(actual) != configs_[smart_port - 1][index])
+                        out.misconfigured.set(smart_port, index + 1);
+                }
+            }
+        }
+
+        /**
+         * Compares the robot against the manifest, using a snapshot for expander presence.
+         *
+         * @param snapshot The snapshot to read expander presence from.
+         *
+         * @return The difference.
+         *
+         * @throws None
+         */
+        AdiDiff diff(const PortSnapshot &snapshot) const
+        {
+            AdiDiff out;
+            diff(snapshot, out);
+            return out;
+        }
+
+    private:
+        std::array<std::array<std::uint8_t, ADI_PORT_COUNT>, SMART_PORT_COUNT> configs_{};
+        ExtendedMask registered_;
+    };
+
+    /**
+     * The maximum number of stages in a `Preflight`.
+     */
+    inline constexpr std::size_t PREFLIGHT_MAX_STAGES = 8;
+
+    /**
+     * The outcome of one preflight stage.
+     */
+    enum class StageResult : std::uint8_t
+    {
+        pending,  ///< The stage has not started.
+        running,  ///< The stage is running.
+        passed,   ///< The stage finished and its check passed.
+        failed,   ///< The stage finished and its check failed.
+        timedOut, ///< The time budget ran out before the stage finished.
+        skipped   ///< The stage was not run.
+    };
+
+    /**
+     * The results of a preflight run. Stages that did not finish in time are reported as `timedOut`.
+     */
+    struct PreflightReport
+    {
+        std::size_t count = 0;                                   ///< The number of stages.
+        std::array<const char *, PREFLIGHT_MAX_STAGES> names{};  ///< The name of each stage.
+        std::array<StageResult, PREFLIGHT_MAX_STAGES> results{}; ///< The outcome of each stage.
+        std::uint32_t elapsed_ms = 0;                            ///< The wall time of the run.
+        std::array<bool, PREFLIGHT_MAX_STAGES> killed{};         ///< Whether each stage had to be removed.
+
+        /**
+         * Checks if every stage finished before the budget ran out.
+         *
+         * @return True if no stage timed out, false otherwise.
+         *
+         * @throws None
+         */
+        bool complete() const
+        {
+            for (std::size_t i = 0; i < count; i++)
+            {
+                if (results[i] == StageResult::timedOut)
+                    return false;
+            }
+            return true;
+        }
+
+        /**
+         * Checks if every stage that ran passed.
+         *
+         * @return True if no stage failed or timed out, false otherwise.
+         *
+         * @throws None
+         */
+        bool passed() const
+        {
+            for (std::size_t i = 0; i < count; i++)
+            {
+                if (results[i] != StageResult::passed && results[i] != StageResult::skipped)
+                    return false;
+            }
+            return true;
+        }
+    };
+
+    /**
+     * A pre-match self test that runs independent checks at the same time under a total time budget.
+     *
+     * Every stage runs in its own `pros::Task` and is given the same `PortSnapshot`, taken once before the stages
+     * start, along with a deadline `STAGE_GRACE_MS` short of the budget, so a stage that waits until its deadline
+     * still has time to return. Stages that are still running when the budget runs out are reported as timed out
+     * and their abort hook is called while they are still alive, for example to stop a spinning motor. They then
+     * get `ABORT_GRACE_MS` to return. Only a stage that still has not returned is removed, as a last resort, and it
+     * is flagged in `PreflightReport::killed`. Its abort hook is then called once more from a short-lived task, so
+     * outputs the stage turned on after the first call are turned off again. Because the stage may have been
+     * removed while holding a port's mutex, that task is given another `ABORT_GRACE_MS` and then removed too, and
+     * `run` never touches the stage's devices itself.
+     *
+     * A stage is any object with `bool operator()(const PortSnapshot &snapshot, std::uint32_t deadline)` and an
+     * optional `void abort()`. `ManifestCheck`, `MotorSpinCheck`, `ImuCheck`, and `RadioCheck` cover the common
+     * checks. Stage objects are not copied, so they must outlive the call to `run`.
+     *
+     * A stage can be marked heavy, either when it is added or with a `static constexpr bool heavy = true` member
+     * like `MotorSpinCheck`. Heavy stages only run while the robot is disabled or not connected to a match; during
+     * the autonomous and driver periods they are reported as `skipped` and only the cheap stages run.
+     *
+     * @code
+     * safety::ManifestCheck ports{robot};
+     * safety::MotorSpinCheck spin{drive};
+     * safety::ImuCheck imu{10};
+     * safety::Preflight preflight;
+     * preflight.add("ports", ports);
+     * preflight.add("drive", spin);
+     * preflight.add("imu", imu);
+     * safety::PreflightReport report = preflight.run(3000);
+     * @endcode
+     */
+    class Preflight
+    {
+    public:
+        /**
+         * The function a stage runs. It returns whether the check passed.
+         */
+        using StageFn = bool (*)(const PortSnapshot &snapshot, std::uint32_t deadline, void *arg);
+
+        /**
+         * The function called when a stage is stopped because the budget ran out.
+         */
+        using AbortFn = void (*)(void *arg);
+
+        /**
+         * How long before the end of the budget the stages' deadline is, so they can return in time.
+         */
+        static constexpr std::uint32_t STAGE_GRACE_MS = 20;
+
+        /**
+         * How long a timed out stage has to return after its abort hook is called before it is removed.
+         */
+        static constexpr std::uint32_t ABORT_GRACE_MS = 50;
+
+        Preflight() = default;
+        Preflight(const Preflight &) = delete;
+        Preflight &operator=(const Preflight &) = delete;
+
+        /**
+         * Adds a stage from plain functions.
+         *
+         * @param name The name of the stage, used for its task and in the report.
+         * @param run The check to run.
+         * @param arg Passed to `run` and `abort`.
+         * @param abort Called if the stage is stopped, or null.
+         * @param heavy Whether to skip the stage during the autonomous and driver periods of a match.
+         *
+         * @return True if the stage was added, false if the pipeline is full.
+         *
+         * @throws None
+         */
+        bool add(const char *name, StageFn run, void *arg = nullptr, AbortFn abort = nullptr, bool heavy = false)
+        {
+            if (count_ == PREFLIGHT_MAX_STAGES)
+                return false;
+            Stage &stage = stages_[count_++];
+            stage.name = name;
+            stage.run = run;
+            stage.abort = abort;
+            stage.arg = arg;
+            stage.heavy = heavy;
+            stage.owner = this;
+            stage.result.store(StageResult::pending, std::memory_order_relaxed);
+            return true;
+        }
+
+        /**
+         * Adds a stage from a check object. The object is not copied.
+         *
+         * @param name The name of the stage, used for its task and in the report.
+         * @param check The check to run. Its `abort()` is called from the coordinating task if the stage times out,
+         *              while the stage may still be running, and again from a cleanup task if the stage has to be
+         *              removed. Its `heavy` member marks it as heavy, if it has one.
+         *
+         * @return True if the stage was added, false if the pipeline is full.
+         *
+         * @throws None
+         */
+        template <typename Check>
+        bool add(const char *name, Check &check)
+        {
+            StageFn run = [](const PortSnapshot &snapshot, std::uint32_t deadline, void *arg)
+            { return static_cast<bool>((*static_cast<Check *>(arg))(snapshot, deadline)); };
+            AbortFn abort = nullptr;
+            if constexpr (requires { check.abort(); })
+                abort = [](void *arg)
+                { static_cast<Check *>(arg)->abort(); };
+            bool heavy = false;
+            if constexpr (requires { Check::heavy; })
+                heavy = Check::heavy;
+            return add(name, run, &check, abort, heavy);
+        }
+
+        /**
+         * Takes a snapshot and runs every stage against it.
+         *
+         * @param budget_ms The total time the stages may take.
+         * @param priority The priority of the stage tasks.
+         *
+         * @return The outcome of every stage.
+         *
+         * @throws None
+         */
+        PreflightReport run(std::uint32_t budget_ms, std::uint32_t priority = TASK_PRIORITY_DEFAULT)
+        {
+            return run(PortSnapshot::capture(), budget_ms, priority);
+        }
+
+        /**
+         * Runs every stage against an existing snapshot, so no port is read again.
+         *
+         * @param snapshot The snapshot to give every stage.
+         * @param budget_ms The total time the stages may take.
+         * @param priority The priority of the stage tasks.
+         *
+         * @return The outcome of every stage.
+         *
+         * @throws None
+         */
+        PreflightReport run(const PortSnapshot &snapshot, std::uint32_t budget_ms,
+                            std::uint32_t priority = TASK_PRIORITY_DEFAULT)
+        {
+            std::uint32_t start = pros::millis();
+            std::uint32_t end = start + budget_ms;
+            snapshot_ = snapshot;
+            deadline_ = end - (budget_ms / 2 < STAGE_GRACE_MS ? budget_ms / 2 : STAGE_GRACE_MS);
+            waiter_.emplace(pros::Task::current());
+            bool skip_heavy = isActivePhase(matchPhase());
+
+            for (std::size_t i = 0; i < count_; i++)
+            {
+                if (skip_heavy && stages_[i].heavy)
+                {
+                    stages_[i].result.store(StageResult::skipped, std::memory_order_relaxed);
+                    continue;
+                }
+                stages_[i].result.store(StageResult::running, std::memory_order_relaxed);
+                stages_[i].done.store(false, std::memory_order_relaxed);
+                stages_[i].task.emplace(entry, &stages_[i], priority, TASK_STACK_DEPTH_DEFAULT, stages_[i].name);
+            }
+
+            waitUntil(end, [this] { return !anyRunning(); });
+
+            for (std::size_t i = 0; i < count_; i++)
+            {
+                Stage &stage = stages_[i];
+                StageResult running = StageResult::running;
+                if (stage.result.compare_exchange_strong(running, StageResult::timedOut, std::memory_order_acq_rel) &&
+                    stage.abort)
+                    stage.abort(stage.arg);
+            }
+
+            waitUntil(pros::millis() + ABORT_GRACE_MS, [this] { return allReturned(); });
+
+            PreflightReport report;
+            report.count = count_;
+            bool cleaning = false;
+            for (std::size_t i = 0; i < count_; i++)
+            {
+                Stage &stage = stages_[i];
+                if (stage.task)
+                {
+                    // A stage that returned is parked and holds nothing, so removing it is safe. One that did not
+                    // is removed as a last resort, and its abort hook runs again from a cleanup task.
+                    if (!stage.done.load(std::memory_order_acquire))
+                        report.killed[i] = true;
+                    stage.task->remove();
+                    stage.task.reset();
+                    if (report.killed[i] && stage.abort)
+                    {
+                        stage.task.emplace(cleanup, &stage, priority, TASK_STACK_DEPTH_DEFAULT, stage.name);
+                        cleaning = true;
+                    }
+                }
+                report.names[i] = stage.name;
+                report.results[i] = stage.result.load(std::memory_order_acquire);
+            }
+
+            if (cleaning)
+            {
+                waitUntil(pros::millis() + ABORT_GRACE_MS, [this] { return allReturned(); });
+                // A cleanup task that has not returned is blocked on the mutex the killed stage held. It holds
+                // nothing itself, so it can be removed.
+                for (std::size_t i = 0; i < count_; i++)
+                {
+                    if (stages_[i].task)
+                    {
+                        stages_[i].task->remove();
+                        stages_[i].task.reset();
+                    }
+                }
+            }
+            report.elapsed_ms = pros::millis() - start;
+            waiter_.reset();
+            return report;
+        }
+
+    private:
+        struct Stage
+        {
+            const char *name = "";
+            StageFn run = nullptr;
+            AbortFn abort = nullptr;
+            void *arg = nullptr;
+            bool heavy = false;
+            Preflight *owner = nullptr;
+            std::atomic<StageResult> result{StageResult::pending};
+            std::atomic<bool> done{false};
+            std::optional<pros::Task> task;
+        };
+
+        static void entry(void *param)
+        {
+            Stage *stage = static_cast<Stage *>(param);
+            Preflight *self = stage->owner;
+            bool ok = stage->run(self->snapshot_, self->deadline_, stage->arg);
+            // Keeps the timedOut result if the coordinator gave up on this stage first.
+            StageResult running = StageResult::running;
+            stage->result.compare_exchange_strong(running, ok ? StageResult::passed : StageResult::failed,
+                                                  std::memory_order_acq_rel);
+            stage->done.store(true, std::memory_order_release);
+            self->waiter_->notify();
+            parkUntilRemoved();
+        }
+
+        static void cleanup(void *param)
+        {
+            Stage *stage = static_cast<Stage *>(param);
+            stage->abort(stage->arg);
+            stage->done.store(true, std::memory_order_release);
+            stage->owner->waiter_->notify();
+            parkUntilRemoved();
+        }
+
+        bool anyRunning() const
+        {
+            for (std::size_t i = 0; i < count_; i++)
+            {
+                if (stages_[i].result.load(std::memory_order_acquire) == StageResult::running)
+                    return true;
+            }
+            return false;
+        }
+
+        bool allReturned() const
+        {
+            for (std::size_t i = 0; i < count_; i++)
+            {
+                if (stages_[i].task && !stages_[i].done.load(std::memory_order_acquire))
+                    return false;
+            }
+            return true;
+        }
+
+        template <typename Done>
+        static void waitUntil(std::uint32_t until, Done done)
+        {
+            while (!done())
+            {
+                std::int32_t remaining = static_cast<std::int32_t>(until - pros::millis());
+                if (remaining <= 0)
+                    break;
+                pros::Task::notify_take(true, static_cast<std::uint32_t>(remaining));
+            }
+        }
+
+        std::array<Stage, PREFLIGHT_MAX_STAGES> stages_;
+        std::size_t count_ = 0;
+        PortSnapshot snapshot_;
+        std::uint32_t deadline_ = 0;
+        std::optional<pros::Task> waiter_;
+    };
+
+    /**
+     * A preflight stage that checks the snapshot against a manifest.
+     */
+    struct ManifestCheck
+    {
+        const Manifest &manifest; ///< The manifest to check against.
+        ManifestDiff diff{};      ///< The difference found by the last run.
+
+        bool operator()(const PortSnapshot &snapshot, std::uint32_t)
+        {
+            manifest.diff(snapshot, diff);
+            return diff.ok();
+        }
+    };
+
+    /**
+     * A preflight stage that spins every motor of a group briefly and checks that each one turns.
+     *
+     * Motors that the snapshot shows as missing fail the stage without being spun. The stage is heavy, so
+     * `Preflight` never spins the motors during a match.
+     */
+    struct MotorSpinCheck
+    {
+        static constexpr bool heavy = true; ///< Skipped during the autonomous and driver periods.
+
+        pros::v5::MotorGroup &group;      ///< The motors to spin.
+        std::int32_t millivolts = 3000;   ///< The voltage to spin them at.
+        std::uint32_t duration_ms = 250;  ///< How long to spin before measuring.
+        double min_rpm = 20;              ///< The slowest speed that counts as turning.
+        MotorGroupReport presence{};      ///< The presence of the motors in the last run.
+        PortMask stalled{};               ///< The motors that did not turn in the last run.
+        std::atomic<bool> aborted{false}; ///< Set by `abort`, so a spin that started late is stopped at once.
+
+        bool operator()(const PortSnapshot &snapshot, std::uint32_t deadline)
+        {
+            // Preflight only aborts after the deadline, which the check below catches, so clearing here is safe.
+            aborted.store(false);
+            stalled = PortMask();
+            presence = inspectMotorGroup(snapshot, group);
+            if (!presence.ok())
+                return false;
+
+            // A stage that only got scheduled after its deadline must not start the motors.
+            std::int32_t remaining = static_cast<std::int32_t>(deadline - pros::millis());
+            if (remaining <= 0)
+                return false;
+            group.move_voltage(millivolts);
+            // If abort ran between the deadline check and the spin, its stop came first; stop the motors again.
+            if (aborted.load())
+            {
+                group.move_voltage(0);
+                return false;
+            }
+            std::uint32_t wait = static_cast<std::uint32_t>(remaining);
+            pros::delay(wait < duration_ms ? wait : duration_ms);
+            for (int i = 0; i < group.size(); i++)
+            {
+                double rpm = group.get_actual_velocity(i);
+                if (rpm == PROS_ERR_F || (rpm < min_rpm && rpm > -min_rpm))
+                    stalled.set(group.get_port(i));
+            }
+            group.move_voltage(0);
+            return stalled.empty();
+        }
+
+        void abort()
+        {
+            aborted.store(true);
+            group.move_voltage(0);
+        }
+    };
+
+    /**
+     * A preflight stage that waits, up to the deadline, for an IMU to finish calibrating.
+     *
+     * Start calibration beforehand with `ImuReady::calibrate` so it overlaps with the other stages.
+     */
+    struct ImuCheck
+    {
+        int port;                              ///< The port of the IMU.
+        std::uint32_t poll_ms = 10;            ///< The time between status checks.
+        ImuStatus status = ImuStatus::missing; ///< The last status that was read.
+
+        bool operator()(const PortSnapshot &snapshot, std::uint32_t deadline)
+        {
+            while (true)
+            {
+                status = imuStatus(snapshot, port);
+                if (status != ImuStatus::calibrating)
+                    return status == ImuStatus::ready;
+                std::int32_t remaining = static_cast<std::int32_t>(deadline - pros::millis());
+                if (remaining <= 0)
+                    return false;
+                std::uint32_t wait = static_cast<std::uint32_t>(remaining);
+                pros::delay(wait < poll_ms ? wait : poll_ms);
+            }
+        }
+    };
+
+    /**
+     * A preflight stage that checks a radio is plugged in and the master controller is connected.
+     */
+    struct RadioCheck
+    {
+        bool operator()(const PortSnapshot &snapshot, std::uint32_t)
+        {
+            return snapshot.ofType(pros::v5::DeviceType::radio).any() &&
+                   pros::c::controller_is_connected(pros::c::E_CONTROLLER_MASTER) == 1;
+        }
+    };
+
+    /**
+     * Keeps a drive MotorGroup driving evenly after some of its motors are lost.
+     *
+     * The group's ports are read once when the helper is built. `update` is called only when the set of lost
+     * motors changes; it precomputes the list of live ports and a fixed-point output scale that makes the
+     * remaining motors cover for the lost ones, up to `max_scale` and the motors' voltage limit. `apply` then
+     * scales and sends a voltage on every control tick with no allocation, division, or `get_port_all()` call.
+     *
+     * Use one helper per side of the drive and apply the same command to both, so the robot still tracks straight
+     * when one side is weaker.
+     */
+    class DegradedDrive
+    {
+    public:
+        /**
+         * The largest voltage a V5 motor accepts, in millivolts.
+         */
+        static constexpr std::int32_t MAX_MILLIVOLTS = 12000;
+
+        /**
+         * Reads the group's ports and starts with every motor live.
+         *
+         * @param group The drive MotorGroup. Reversed motors keep their direction.
+         * @param max_scale The largest factor the remaining motors' output may be multiplied by.
+         */
+        explicit DegradedDrive(const pros::v5::MotorGroup &group, float max_scale = 2.0f) : max_scale_(max_scale)
+        {
+            int size = group.size();
+            count_ = size < 0 ? 0 : size > SMART_PORT_COUNT ? SMART_PORT_COUNT : static_cast<std::size_t>(size);
+            for (std::size_t i = 0; i < count_; i++)
+            {
+                ports_[i] = group.get_port(i);
+                group_.set(ports_[i]);
+            }
+            update(PortMask());
+        }
+
+        /**
+         * Recomputes the live ports and output scale. Ports outside the group are ignored.
+         *
+         * A newly lost port is sent 0 V once, since `apply` no longer commands it and a motor that is still
+         * attached, for example one flagged for overheating, would otherwise keep its last voltage.
+         *
+         * @param lost The ports that have lost their motor, for example from `MotorGroupReport::bad()`.
+         *
+         * @throws None
+         */
+        void update(PortMask lost)
+        {
+            PortMask was_lost = lost_;
+            lost_ = lost & group_;
+            live_count_ = 0;
+            for (std::size_t i = 0; i < count_; i++)
+            {
+                if (!lost_.test(ports_[i]))
+                    live_[live_count_++] = ports_[i];
+                else if (!was_lost.test(ports_[i]))
+                    pros::c::motor_move_voltage(ports_[i], 0);
+            }
+
+            if (live_count_ == 0)
+            {
+                scale_q16_ = 0;
+                return;
+            }
+            float scale = static_cast<float>(count_) / static_cast<float>(live_count_);
+            scale = scale > max_scale_ ? max_scale_ : scale;
+            scale_q16_ = static_cast<std::int32_t>(scale * 65536.0f + 0.5f);
+        }
+
+        /**
+         * Sends a scaled voltage to every live motor.
+         *
+         * @param millivolts The voltage the whole group would get with every motor live, from -12000 to 12000.
+         *
+         * @throws None
+         */
+        void apply(std::int32_t millivolts) const
+        {
+            std::int64_t product = static_cast<std::int64_t>(millivolts) * scale_q16_;
+            std::int32_t scaled = static_cast<std::int32_t>((product + (1 << 15)) >> 16);
+            scaled = scaled > MAX_MILLIVOLTS ? MAX_MILLIVOLTS : scaled < -MAX_MILLIVOLTS ? -MAX_MILLIVOLTS : scaled;
+            for (std::size_t i = 0; i < live_count_; i++)
+                pros::c::motor_move_voltage(live_[i], scaled);
+        }
+
+        /**
+         * Gets the ports of the group that are treated as lost.
+         *
+         * @return A mask of the lost ports.
+         *
+         * @throws None
+         */
+        PortMask lost() const
+        {
+            return lost_;
+        }
+
+        /**
+         * Checks if any motor of the group is lost.
+         *
+         * @return True if the drive is running degraded, false otherwise.
+         *
+         * @throws None
+         */
+        bool degraded() const
+        {
+            return lost_.any();
+        }
+
+        /**
+         * Gets the number of live motors.
+         *
+         * @return The number of motors `apply` drives.
+         *
+         * @throws None
+         */
+        std::size_t liveCount() const
+        {
+            return live_count_;
+        }
+
+        /**
+         * Gets the factor `apply` multiplies commands by.
+         *
+         * @return The output scale, or 0 if every motor is lost.
+         *
+         * @throws None
+         */
+        float scale() const
+        {
+            return static_cast<float>(scale_q16_) / 65536.0f;
+        }
+
+    private:
+        float max_scale_;
+        std::size_t count_ = 0;
+        std::size_t live_count_ = 0;
+        std::array<std::int8_t, SMART_PORT_COUNT> ports_{};
+        std::array<std::int8_t, SMART_PORT_COUNT> live_{};
+        PortMask group_;
+        PortMask lost_;
+        std::int32_t scale_q16_ = 0;
+    };
+
+    /**
+     * One entry of the binary event log, stored on the SD card exactly as laid out here in little-endian order.
+     *
+     * A record whose port is `EVENT_LOG_SESSION_PORT` marks the start of a new session; its time is when the log
+     * was opened. `tools/decode_events.cpp` turns a log file into CSV.
+     */
+    struct EventRecord
+    {
+        std::uint32_t time;    ///< The value of `pros::millis()` when the change was seen.
+        std::uint8_t port;     ///< The smart port that changed, or `EVENT_LOG_SESSION_PORT`.
+        std::uint8_t kind;     ///< The `PortEventKind` of the change.
+        std::uint8_t previous; ///< The `pros::v5::DeviceType` before the change.
+        std::uint8_t current;  ///< The `pros::v5::DeviceType` after the change.
+    };
+
+    static_assert(sizeof(EventRecord) == 8, "EventRecord must match the on-card log format");
+
+    /**
+     * The port number used by session marker records in the event log.
+     */
+    inline constexpr std::uint8_t EVENT_LOG_SESSION_PORT = 0;
+
+    /**
+     * Records port events to the SD card with large batched writes from a low-priority task.
+     *
+     * `record` only copies an 8-byte `EventRecord` into a RAM ring, so it is cheap enough to call from an
+     * `EventBus` callback. The flush task wakes every `flush_ms`, or sooner once the ring is half full, and writes
+     * everything queued with a few `fwrite` calls of up to `BATCH_RECORDS` records. The file is opened once in
+     * append mode. If no SD card is inserted, records wait in RAM and are dropped once the ring is full. With
+     * `deferDuringMatch`, the task holds writes back during the autonomous and driver periods until the ring is
+     * `DEFER_LIMIT` full, so SD card writes land in the disabled windows instead.
+     *
+     * @code
+     * static safety::EventLog log;
+     * bus.subscribe(safety::PortMask::all(), safety::ALL_PORT_EVENTS, safety::EventLog::onEvent, &log);
+     * log.start();
+     * @endcode
+     */
+    class EventLog
+    {
+    public:
+        /**
+         * The number of records the RAM ring can hold.
+         */
+        static constexpr std::size_t CAPACITY = 256;
+
+        /**
+         * The most records written by a single `fwrite`.
+         */
+        static constexpr std::size_t BATCH_RECORDS = 64;
+
+        /**
+         * The number of queued records at which a deferred flush happens anyway, so events are not dropped.
+         */
+        static constexpr std::size_t DEFER_LIMIT = CAPACITY * 3 / 4;
+
+        /**
+         * Creates a stopped log.
+         *
+         * @param path The file to append to. It must stay valid while the log is in use.
+         * @param flush_ms The longest time a record waits in RAM before it is written.
+         */
+        explicit EventLog(const char *path = "/usd/safety_events.bin", std::uint32_t flush_ms = 1000)
+            : path_(path), flush_ms_(flush_ms)
+        {
+        }
+
+        EventLog(const EventLog &) = delete;
+        EventLog &operator=(const EventLog &) = delete;
+
+        ~EventLog()
+        {
+            stop();
+        }
+
+        /**
+         * Queues an event to be written. Call this from a single producer task.
+         *
+         * @param event The event to record.
+         *
+         * @return True if the event was queued, false if the ring was full and the event was dropped.
+         *
+         * @throws None
+         */
+        bool record(const PortEvent &event)
+        {
+            EventRecord record{event.time, event.port, static_cast<std::uint8_t>(event.kind),
+                               static_cast<std::uint8_t>(event.previous), static_cast<std::uint8_t>(event.current)};
+            if (!records_.push(record))
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (records_.size() >= CAPACITY / 2)
+                notifier_.notify();
+            return true;
+        }
+
+        /**
+         * An `EventBus::Callback` that records the event into the `EventLog` passed as `arg`.
+         *
+         * @param event The event to record.
+         * @param arg The `EventLog`.
+         *
+         * @throws None
+         */
+        static void onEvent(const PortEvent &event, void *arg)
+        {
+            static_cast<EventLog *>(arg)->record(event);
+        }
+
+        /**
+         * Starts the flush task. Does nothing if it is already running.
+         *
+         * @param priority The priority of the flush task.
+         *
+         * @throws None
+         */
+        void start(std::uint32_t priority = TASK_PRIORITY_MIN)
+        {
+            if (task_)
+                return;
+            stopping_.store(false, std::memory_order_relaxed);
+            finished_.store(false, std::memory_order_relaxed);
+            task_.emplace(run, this, priority, TASK_STACK_DEPTH_DEFAULT, "safety log");
+            notifier_.publish(*task_);
+        }
+
+        /**
+         * Writes whatever is still queued, closes the file, and stops the flush task.
+         *
+         * The flush task is asked to finish and does the final write itself, so it is never stopped in the middle
+         * of a write. This waits until it is done. Call it from a single task.
+         *
+         * If the flush task is suspended, or was removed elsewhere, before it confirms it is done, it may have
+         * stopped halfway through a write. Its file is then abandoned rather than flushed or closed from here,
+         * and records still queued stay queued. The next `start` or `flush` opens the file again.
+         *
+         * @throws None
+         */
+        void stop()
+        {
+            if (!task_)
+            {
+                close();
+                return;
+            }
+            notifier_.withdraw();
+            stopTask(task_, stopping_, finished_);
+            if (!finished_.load(std::memory_order_acquire))
+                file_ = nullptr;
+        }
+
+        /**
+         * Writes every queued record to the file. The flush task calls this; it can also be called directly
+         * while the task is stopped.
+         *
+         * @return The number of records written.
+         *
+         * @throws None
+         */
+        std::size_t flush()
+        {
+            if (records_.empty() || !open())
+                return 0;
+
+            std::size_t total = 0;
+            std::size_t count = 0;
+            while (records_.pop(batch_[count]))
+            {
+                if (++count == BATCH_RECORDS)
+                {
+                    total += write(count);
+                    count = 0;
+                }
+            }
+            total += write(count);
+            std::fflush(file_);
+            written_.fetch_add(static_cast<std::uint32_t>(total), std::memory_order_relaxed);
+            return total;
+        }
+
+        /**
+         * Sets whether the flush task holds writes back during the autonomous and driver periods of a match.
+         * Direct calls to `flush` always write. Safe to call from any task.
+         *
+         * @param defer True to defer writes during a match, false to write on every wake.
+         *
+         * @throws None
+         */
+        void deferDuringMatch(bool defer = true)
+        {
+            defer_.store(defer, std::memory_order_relaxed);
+        }
+
+        /**
+         * Gets the number of records dropped because the ring was full.
+         *
+         * @return The number of dropped records.
+         *
+         * @throws None
+         */
+        std::uint32_t dropped() const
+        {
+            return dropped_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Gets the number of event records written to the file, not counting session markers.
+         *
+         * @return The number of written records.
+         *
+         * @throws None
+         */
+        std::uint32_t written() const
+        {
+            return written_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        static void run(void *param)
+        {
+            EventLog *self = static_cast<EventLog *>(param);
+            while (!self->stopping_.load(std::memory_order_acquire))
+            {
+                pros::Task::notify_take(true, self->flush_ms_);
+                if (self->stopping_.load(std::memory_order_acquire))
+                    break;
+                if (self->defer_.load(std::memory_order_relaxed) && self->records_.size() < DEFER_LIMIT &&
+                    isActivePhase(matchPhase()))
+                    continue;
+                self->flush();
+            }
+            self->close();
+            self->finished_.store(true, std::memory_order_release);
+            parkUntilRemoved();
+        }
+
+        void close()
+        {
+            flush();
+            if (file_)
+            {
+                std::fclose(file_);
+                file_ = nullptr;
+            }
+        }
+
+        bool open()
+        {
+            if (file_)
+                return true;
+            if (pros::usd::is_installed() != 1)
+                return false;
+            file_ = std::fopen(path_, "ab");
+            if (!file_)
+                return false;
+            EventRecord session{pros::millis(), EVENT_LOG_SESSION_PORT, 0, 0, 0};
+            std::fwrite(&session, sizeof(session), 1, file_);
+            return true;
+        }
+
+        std::size_t write(std::size_t count)
+        {
+            if (count == 0)
+                return 0;
+            return std::fwrite(batch_.data(), sizeof(EventRecord), count, file_);
+        }
+
+        const char *path_;
+        std::uint32_t flush_ms_;
+        std::FILE *file_ = nullptr;
+        SpscRing<EventRecord, CAPACITY> records_;
+        std::array<EventRecord, BATCH_RECORDS> batch_{};
+        std::atomic<std::uint32_t> dropped_{0};
+        std::atomic<std::uint32_t> written_{0};
+        std::atomic<bool> defer_{false};
+        std::atomic<bool> stopping_{false};
+        std::atomic<bool> finished_{false};
+        TaskNotifier notifier_;
+        std::optional<pros::Task> task_;
+    };
+
+    /**
+     * A 7 by 3 grid of the smart ports on the brain screen that only redraws cells whose state changed.
+     *
+     * Each cell shows the port number and device type on a color that compares the port against a `Manifest`:
+     * green when the expected device is there, red when it is missing, orange when the wrong type is plugged in,
+     * blue for an unexpected device, and grey for an empty unregistered port. State changes arrive from watchdog
+     * events on any task and only set a bit in a dirty mask. `draw`, called from the screen task, repaints the
+     * dirty cells, so a frame with no changes costs one atomic exchange.
+     *
+     * @code
+     * safety::Dashboard dashboard(robot);
+     * bus.subscribe(safety::PortMask::all(), safety::ALL_PORT_EVENTS, safety::Dashboard::onEvent, &dashboard);
+     * dashboard.update(watchdog.snapshot());
+     * while (true)
+     * {
+     *     dashboard.draw();
+     *     pros::delay(50);
+     * }
+     * @endcode
+     */
+    class Dashboard
+    {
+    public:
+        static constexpr int COLUMNS = 7;                   ///< Cells per row.
+        static constexpr int ROWS = 3;                      ///< Rows of cells.
+        static constexpr std::int16_t CELL_WIDTH = 68;      ///< Cell width in pixels.
+        static constexpr std::int16_t CELL_HEIGHT = 80;     ///< Cell height in pixels.
+        static constexpr std::uint32_t COLOR_OK = 0x00008800;         ///< The expected device is plugged in.
+        static constexpr std::uint32_t COLOR_MISSING = 0x00C00000;    ///< A registered port is empty.
+        static constexpr std::uint32_t COLOR_WRONG_TYPE = 0x00D08000; ///< A registered port holds another type.
+        static constexpr std::uint32_t COLOR_UNEXPECTED = 0x000050B0; ///< An unregistered port holds a device.
+        static constexpr std::uint32_t COLOR_EMPTY = 0x00303030;      ///< An unregistered port is empty.
+        static constexpr std::uint32_t COLOR_TEXT = 0x00FFFFFF;       ///< Port numbers and type names.
+
+        /**
+         * Creates a dashboard that shows every port as empty until it is updated, with every cell dirty.
+         *
+         * @param manifest The devices the robot expects. Copied.
+         */
+        explicit Dashboard(const Manifest &manifest = Manifest()) : manifest_(manifest)
+        {
+            for (std::atomic<std::uint8_t> &type : types_)
+                type.store(static_cast<std::uint8_t>(pros::v5::DeviceType::none), std::memory_order_relaxed);
+        }
+
+        Dashboard(const Dashboard &) = delete;
+        Dashboard &operator=(const Dashboard &) = delete;
+
+        /**
+         * Records a watchdog event and marks its cell dirty. Safe to call from any task.
+         *
+         * @param event The event to record.
+         *
+         * @throws None
+         */
+        void push(const PortEvent &event)
+        {
+            if (event.port < 1 || event.port > SMART_PORT_COUNT)
+                return;
+            types_[event.port - 1].store(static_cast<std::uint8_t>(event.current), std::memory_order_relaxed);
+            dirty_.fetch_or(PortMask().set(event.port).bits(), std::memory_order_release);
+        }
+
+        /**
+         * An `EventBus::Callback` that records the event into the `Dashboard` passed as `arg`.
+         *
+         * @param event The event to record.
+         * @param arg The `Dashboard`.
+         *
+         * @throws None
+         */
+        static void onEvent(const PortEvent &event, void *arg)
+        {
+            static_cast<Dashboard *>(arg)->push(event);
+        }
+
+        /**
+         * Copies the port types of a snapshot and marks the cells that changed dirty. Safe to call from any task.
+         *
+         * @param snapshot The snapshot to show, for example from `Watchdog::snapshot`.
+         *
+         * @throws None
+         */
+        void update(const PortSnapshot &snapshot)
+        {
+            PortMask changed;
+            for (int port = 1; port <= SMART_PORT_COUNT; port++)
+            {
+                std::uint8_t type = static_cast<std::uint8_t>(snapshot.type(port));
+                if (types_[port - 1].exchange(type, std::memory_order_relaxed) != type)
+                    changed.set(port);
+            }
+            if (changed.any())
+                dirty_.fetch_or(changed.bits(), std::memory_order_release);
+        }
+
+        /**
+         * Forces cells to be repainted on the next `draw`, for example after something else drew on the screen.
+         *
+         * @param ports The cells to repaint.
+         *
+         * @throws None
+         */
+        void invalidate(PortMask ports = PortMask::all())
+        {
+            dirty_.fetch_or(ports.bits(), std::memory_order_release);
+        }
+
+        /**
+         * Gets the cells that will be repainted on the next `draw`.
+         *
+         * @return A mask of the dirty cells.
+         *
+         * @throws None
+         */
+        PortMask dirty() const
+        {
+            return PortMask(dirty_.load(std::memory_order_acquire));
+        }
+
+        /**
+         * Repaints the dirty cells. Call this from a single task, usually the screen task.
+         *
+         * @return The number of cells repainted.
+         *
+         * @throws None
+         */
+        int draw()
+        {
+            PortMask dirty(dirty_.exchange(0, std::memory_order_acquire));
+            for (int port : dirty)
+                drawCell(port);
+            return dirty.count();
+        }
+
+    private:
+        std::uint32_t color(int port, pros::v5::DeviceType actual) const
+        {
+            bool plugged = !(actual == pros::v5::DeviceType::none || actual == pros::v5::DeviceType::undefined);
+            if (!manifest_.ports().test(port))
+                return plugged ? COLOR_UNEXPECTED : COLOR_EMPTY;
+            if (!plugged)
+                return COLOR_MISSING;
+            return actual == manifest_.expected(port) ? COLOR_OK : COLOR_WRONG_TYPE;
+        }
+
+        void drawCell(int port)
+        {
+            pros::v5::DeviceType actual =
+                static_cast<pros::v5::DeviceType>(types_[port - 1].load(std::memory_order_relaxed));
+            bool plugged = !(actual == pros::v5::DeviceType::none || actual == pros::v5::DeviceType::undefined);
+            std::int16_t x = static_cast<std::int16_t>((port - 1) % COLUMNS * CELL_WIDTH);
+            std::int16_t y = static_cast<std::int16_t>((port - 1) / COLUMNS * CELL_HEIGHT);
+            std::uint32_t fill = color(port, actual);
+
+            pros::screen::set_pen(fill);
+            pros::screen::fill_rect(x + 1, y + 1, x + CELL_WIDTH - 2, y + CELL_HEIGHT - 2);
+            pros::screen::set_eraser(fill);
+            pros::screen::set_pen(COLOR_TEXT);
+            pros::screen::print(pros::E_TEXT_MEDIUM, x + 6, y + 8, "%d", port);
+            if (plugged || manifest_.ports().test(port))
+            {
+                const char *name = deviceType_to_string(plugged ? actual : manifest_.expected(port));
+                pros::screen::print(pros::E_TEXT_SMALL, x + 6, y + CELL_HEIGHT - 24, "%s", name);
+            }
+        }
+
+        Manifest manifest_;
+        std::array<std::atomic<std::uint8_t>, SMART_PORT_COUNT> types_;
+        std::atomic<std::uint32_t> dirty_{PortMask::all().bits()};
+    };
 } // namespace
 
 // Written by: Adam Salem for PROS 4.0
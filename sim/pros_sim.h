@@ -0,0 +1,687 @@
+/**
+ * @file pros_sim.h
+ * @brief Host-side stand-in for the parts of the PROS 4 api that safety.h uses, backed by a fake device table.
+ * @author Adam Salem
+ * @copyright Copyright (c) 2024 Adam Salem
+ *
+ * Define `SAFETY_SIM` before including safety.h and it includes this header instead of `api.h`, so the library
+ * builds with a normal desktop compiler. Ports, motors, the IMU status, the controller, and the clock are all
+ * simulated through `safety::sim`. Plug and unplug timelines can be scripted with `safety::sim::schedule` and played
+ * back with `safety::sim::advance`.
+ *
+ * There is no scheduler in the simulation: `pros::Task` objects never run their function and `pros::delay` only
+ * advances the simulated clock. Drive the library from your own loop instead, by calling `Watchdog::sample`,
+ * `EventBus::dispatch`, and `EventLog::flush` between calls to `advance`.
+ *
+ * @code
+ * #define SAFETY_SIM
+ * #include "safety.h"
+ *
+ * safety::sim::setType(1, pros::v5::DeviceType::motor);
+ * safety::sim::schedule(500, 1, pros::v5::DeviceType::none);
+ * safety::Watchdog watchdog;
+ * watchdog.start(); // takes the baseline; the task itself never runs
+ * for (int tick = 0; tick < 1000000; tick++)
+ * {
+ *     watchdog.sample();
+ *     safety::sim::advance(watchdog.period());
+ * }
+ * @endcode
+ */
+
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#define PROS_ERR (INT32_MAX)
+#define PROS_ERR_F (INFINITY)
+
+#define TASK_PRIORITY_MAX 16
+#define TASK_PRIORITY_MIN 1
+#define TASK_PRIORITY_DEFAULT 8
+#define TASK_STACK_DEPTH_DEFAULT 0x2000
+#define TASK_STACK_DEPTH_MIN 0x200
+#define TIMEOUT_MAX ((std::uint32_t)0xffffffffUL)
+
+#define COMPETITION_DISABLED (1 << 0)
+#define COMPETITION_AUTONOMOUS (1 << 1)
+#define COMPETITION_CONNECTED (1 << 2)
+#define COMPETITION_SYSTEM (1 << 3)
+
+namespace pros
+{
+    typedef enum
+    {
+        E_TEXT_SMALL = 0,
+        E_TEXT_MEDIUM,
+        E_TEXT_LARGE,
+        E_TEXT_MEDIUM_CENTER,
+        E_TEXT_LARGE_CENTER
+    } text_format_e_t;
+
+    typedef enum adi_port_config_e
+    {
+        E_ADI_ANALOG_IN = 0,
+        E_ADI_ANALOG_OUT = 1,
+        E_ADI_DIGITAL_IN = 2,
+        E_ADI_DIGITAL_OUT = 3,
+        E_ADI_LEGACY_GYRO = 10,
+        E_ADI_LEGACY_SERVO = 12,
+        E_ADI_LEGACY_PWM = 13,
+        E_ADI_LEGACY_ENCODER = 14,
+        E_ADI_LEGACY_ULTRASONIC = 15,
+        E_ADI_TYPE_UNDEFINED = 255,
+        E_ADI_ERR = PROS_ERR
+    } adi_port_config_e_t;
+
+    inline namespace v5
+    {
+        /**
+         * The device types reported by `Device::get_plugged_type`, with the same values as PROS 4.
+         */
+        enum class DeviceType
+        {
+            none = 0,
+            motor = 2,
+            rotation = 4,
+            imu = 6,
+            distance = 7,
+            radio = 8,
+            vision = 11,
+            adi = 12,
+            optical = 16,
+            gps = 20,
+            serial = 129,
+            undefined = 255
+        };
+    } // namespace v5
+
+    namespace c
+    {
+        typedef enum imu_status_e
+        {
+            E_IMU_STATUS_READY = 0,
+            E_IMU_STATUS_CALIBRATING = 0x01,
+            E_IMU_STATUS_ERROR = 0xFF
+        } imu_status_e_t;
+
+        typedef enum
+        {
+            E_CONTROLLER_MASTER = 0,
+            E_CONTROLLER_PARTNER
+        } controller_id_e_t;
+
+        typedef struct imu_raw_s
+        {
+            double x;
+            double y;
+            double z;
+            double w;
+        } imu_raw_s;
+
+        typedef struct imu_raw_s imu_accel_s_t;
+    } // namespace c
+} // namespace pros
+
+namespace safety::sim
+{
+    /**
+     * The largest port number the simulation tracks.
+     */
+    inline constexpr int MAX_PORT = 21;
+
+    /**
+     * The maximum number of scripted changes waiting to be played back.
+     */
+    inline constexpr std::size_t TIMELINE_CAPACITY = 256;
+
+    /**
+     * The simulated state of one motor.
+     */
+    struct MotorState
+    {
+        double temperature = 25.0;       ///< Reported temperature in degrees Celsius.
+        std::int32_t current_ma = 0;     ///< Reported current draw in milliamps.
+        bool over_temp = false;          ///< Reported over-temperature flag.
+        bool over_current = false;       ///< Reported over-current flag.
+        std::int32_t millivolts = 0;     ///< The last voltage commanded, with the port's direction applied.
+        double rpm_per_volt = 200 / 12.0; ///< Speed the motor reaches per commanded volt.
+    };
+
+    /**
+     * A device type change scheduled for a point on the simulated clock.
+     */
+    struct ScriptedChange
+    {
+        std::uint32_t time_ms;     ///< When the change happens.
+        std::uint8_t port;         ///< The port that changes.
+        pros::v5::DeviceType type; ///< The type the port reports after the change.
+    };
+
+    /**
+     * Everything the simulation tracks.
+     */
+    struct State
+    {
+        std::uint64_t now_us = 0;
+        std::array<pros::v5::DeviceType, MAX_PORT + 1> types{};
+        std::array<MotorState, MAX_PORT + 1> motors{};
+        std::array<pros::c::imu_status_e_t, MAX_PORT + 1> imu_status{};
+        std::array<pros::c::imu_accel_s_t, MAX_PORT + 1> imu_accel{};
+        std::array<std::array<pros::adi_port_config_e_t, 8>, MAX_PORT + 1> adi_config{};
+        std::array<ScriptedChange, TIMELINE_CAPACITY> timeline{};
+        std::size_t timeline_size = 0;
+        std::uint64_t type_reads = 0;
+        bool controller_connected = true;
+        std::uint8_t competition_status = 0;
+        bool sd_installed = false;
+        std::array<std::array<char, 20>, 3> controller_text{};
+        std::uint32_t controller_messages = 0;
+        std::uint32_t rumbles = 0;
+        std::uint32_t screen_pen = 0;
+        std::uint32_t screen_eraser = 0;
+        std::uint32_t screen_fills = 0;
+        std::uint32_t screen_prints = 0;
+    };
+
+    /**
+     * Gets the simulation state.
+     *
+     * @return The single simulation state shared by every translation unit.
+     */
+    inline State &state()
+    {
+        static State instance;
+        return instance;
+    }
+
+    /**
+     * Puts the simulation back to time zero with every port empty.
+     */
+    inline void reset()
+    {
+        state() = State();
+    }
+
+    /**
+     * Gets the simulated time.
+     *
+     * @return The time in milliseconds.
+     */
+    inline std::uint32_t millis()
+    {
+        return static_cast<std::uint32_t>(state().now_us / 1000);
+    }
+
+    /**
+     * Sets the device type a port reports from now on.
+     *
+     * @param port The port number, from 1 to 21.
+     * @param type The device type to report.
+     */
+    inline void setType(int port, pros::v5::DeviceType type)
+    {
+        if (port >= 1 && port <= MAX_PORT)
+            state().types[port] = type;
+    }
+
+    /**
+     * Gets the device type a port reports.
+     *
+     * @param port The port number.
+     *
+     * @return The device type, or `pros::v5::DeviceType::undefined` for an invalid port.
+     */
+    inline pros::v5::DeviceType type(int port)
+    {
+        if (port < 1 || port > MAX_PORT)
+            return pros::v5::DeviceType::undefined;
+        return state().types[port];
+    }
+
+    /**
+     * Schedules a port to report a new device type at a point on the simulated clock.
+     *
+     * @param time_ms When the change happens.
+     * @param port The port number, from 1 to 21.
+     * @param type The device type the port reports after the change.
+     *
+     * @return True if the change was scheduled, false if the timeline is full or the port is invalid.
+     */
+    inline bool schedule(std::uint32_t time_ms, int port, pros::v5::DeviceType type)
+    {
+        State &sim = state();
+        if (port < 1 || port > MAX_PORT || sim.timeline_size == TIMELINE_CAPACITY)
+            return false;
+        // Keep the timeline sorted by time, with changes at the same time in the order they were scheduled.
+        std::size_t i = sim.timeline_size++;
+        while (i > 0 && sim.timeline[i - 1].time_ms > time_ms)
+        {
+            sim.timeline[i] = sim.timeline[i - 1];
+            i--;
+        }
+        sim.timeline[i] = {time_ms, static_cast<std::uint8_t>(port), type};
+        return true;
+    }
+
+    /**
+     * Schedules a port to flicker to another type and back, as a loose cable does.
+     *
+     * @param time_ms When the glitch starts.
+     * @param port The port number, from 1 to 21.
+     * @param glitch The type reported during the glitch.
+     * @param restore The type reported after the glitch.
+     * @param duration_ms How long the glitch lasts.
+     *
+     * @return True if both changes were scheduled, false otherwise.
+     */
+    inline bool scheduleGlitch(std::uint32_t time_ms, int port, pros::v5::DeviceType glitch,
+                               pros::v5::DeviceType restore, std::uint32_t duration_ms)
+    {
+        return schedule(time_ms, port, glitch) && schedule(time_ms + duration_ms, port, restore);
+    }
+
+    /**
+     * Moves the simulated clock forward and applies every scripted change that has come due.
+     *
+     * @param ms The time to advance by, in milliseconds.
+     */
+    inline void advance(std::uint32_t ms)
+    {
+        State &sim = state();
+        sim.now_us += static_cast<std::uint64_t>(ms) * 1000;
+        std::uint32_t now = millis();
+        std::size_t due = 0;
+        while (due < sim.timeline_size && sim.timeline[due].time_ms <= now)
+        {
+            sim.types[sim.timeline[due].port] = sim.timeline[due].type;
+            due++;
+        }
+        if (due == 0)
+            return;
+        for (std::size_t i = due; i < sim.timeline_size; i++)
+            sim.timeline[i - due] = sim.timeline[i];
+        sim.timeline_size -= due;
+    }
+
+    /**
+     * Gets the simulated state of the motor on a port.
+     *
+     * @param port The port number, from 1 to 21. Reversed (negative) ports are accepted.
+     *
+     * @return The motor state.
+     */
+    inline MotorState &motor(int port)
+    {
+        port = port < 0 ? -port : port;
+        return state().motors[port >= 1 && port <= MAX_PORT ? port : 0];
+    }
+
+    /**
+     * Sets the status flags an IMU reports.
+     *
+     * @param port The port number, from 1 to 21.
+     * @param status The status to report.
+     */
+    inline void setImuStatus(int port, pros::c::imu_status_e_t status)
+    {
+        if (port >= 1 && port <= MAX_PORT)
+            state().imu_status[port] = status;
+    }
+
+    /**
+     * Sets the acceleration an IMU reports.
+     *
+     * @param port The port number, from 1 to 21.
+     * @param x The acceleration along the x axis in g.
+     * @param y The acceleration along the y axis in g.
+     * @param z The acceleration along the z axis in g.
+     */
+    inline void setImuAccel(int port, double x, double y, double z)
+    {
+        if (port >= 1 && port <= MAX_PORT)
+            state().imu_accel[port] = {x, y, z, 0};
+    }
+
+    /**
+     * Sets the configuration a 3-wire port behind an ADI expander reports.
+     *
+     * @param smart_port The smart port of the expander, from 1 to 21.
+     * @param adi_port The 3-wire port, from 1 to 8.
+     * @param config The configuration to report.
+     */
+    inline void setAdiConfig(int smart_port, int adi_port, pros::adi_port_config_e_t config)
+    {
+        if (smart_port >= 1 && smart_port <= MAX_PORT && adi_port >= 1 && adi_port <= 8)
+            state().adi_config[smart_port][adi_port - 1] = config;
+    }
+
+    /**
+     * Sets the competition status the field or competition switch reports.
+     *
+     * @param status A combination of `COMPETITION_CONNECTED`, `COMPETITION_DISABLED`, and `COMPETITION_AUTONOMOUS`,
+     *               or 0 for no competition control.
+     */
+    inline void setCompetitionStatus(std::uint8_t status)
+    {
+        state().competition_status = status;
+    }
+
+    /**
+     * Gets the number of `get_plugged_type` calls made so far, for measuring algorithmic cost.
+     *
+     * @return The number of port type reads.
+     */
+    inline std::uint64_t typeReads()
+    {
+        return state().type_reads;
+    }
+} // namespace safety::sim
+
+namespace pros
+{
+    inline std::uint32_t millis()
+    {
+        return safety::sim::millis();
+    }
+
+    inline std::uint64_t micros()
+    {
+        return safety::sim::state().now_us;
+    }
+
+    inline void delay(const std::uint32_t milliseconds)
+    {
+        safety::sim::advance(milliseconds);
+    }
+
+    typedef void *task_t;
+    typedef void (*task_fn_t)(void *);
+
+    typedef enum
+    {
+        E_TASK_STATE_RUNNING = 0,
+        E_TASK_STATE_READY,
+        E_TASK_STATE_BLOCKED,
+        E_TASK_STATE_SUSPENDED,
+        E_TASK_STATE_DELETED,
+        E_TASK_STATE_INVALID
+    } task_state_e_t;
+
+    /**
+     * A task handle that never runs its function. See the file comment.
+     */
+    class Task
+    {
+    public:
+        Task(task_fn_t, void * = nullptr, std::uint32_t = TASK_PRIORITY_DEFAULT,
+             std::uint16_t = TASK_STACK_DEPTH_DEFAULT, const char * = "")
+        {
+        }
+
+        explicit Task(task_t)
+        {
+        }
+
+        static Task current()
+        {
+            return Task(task_t{});
+        }
+
+        void remove()
+        {
+        }
+
+        std::uint32_t get_state()
+        {
+            // Task functions never run in the simulation, so report the task as suspended.
+            return E_TASK_STATE_SUSPENDED;
+        }
+
+        std::uint32_t notify()
+        {
+            return 1;
+        }
+
+        static std::uint32_t notify_take(bool, std::uint32_t timeout)
+        {
+            if (timeout != TIMEOUT_MAX)
+                delay(timeout);
+            return 0;
+        }
+
+        static void delay_until(std::uint32_t *const prev_time, const std::uint32_t delta)
+        {
+            *prev_time += delta;
+            std::uint32_t now = millis();
+            if (static_cast<std::int32_t>(*prev_time - now) > 0)
+                delay(*prev_time - now);
+        }
+    };
+
+    inline namespace v5
+    {
+        class Device
+        {
+        public:
+            explicit Device(const std::uint8_t port) : _port(port)
+            {
+            }
+
+            virtual ~Device() = default;
+
+            std::uint8_t get_port() const
+            {
+                return _port;
+            }
+
+            static DeviceType get_plugged_type(std::uint8_t port)
+            {
+                safety::sim::state().type_reads++;
+                return safety::sim::type(port);
+            }
+
+        protected:
+            std::uint8_t _port;
+        };
+
+        class MotorGroup
+        {
+        public:
+            MotorGroup(const std::initializer_list<std::int8_t> ports) : _ports(ports)
+            {
+            }
+
+            MotorGroup(const std::vector<std::int8_t> &ports) : _ports(ports)
+            {
+            }
+
+            std::int8_t size() const
+            {
+                return static_cast<std::int8_t>(_ports.size());
+            }
+
+            std::int8_t get_port(const std::uint8_t index = 0) const
+            {
+                return index < _ports.size() ? _ports[index] : PROS_ERR_BYTE;
+            }
+
+            std::vector<std::int8_t> get_port_all() const
+            {
+                return _ports;
+            }
+
+            double get_temperature(const std::uint8_t index = 0) const
+            {
+                return present(index) ? safety::sim::motor(_ports[index]).temperature : PROS_ERR_F;
+            }
+
+            std::int32_t get_current_draw(const std::uint8_t index = 0) const
+            {
+                return present(index) ? safety::sim::motor(_ports[index]).current_ma : PROS_ERR;
+            }
+
+            std::int32_t is_over_temp(const std::uint8_t index = 0) const
+            {
+                return present(index) ? safety::sim::motor(_ports[index]).over_temp : PROS_ERR;
+            }
+
+            std::int32_t is_over_current(const std::uint8_t index = 0) const
+            {
+                return present(index) ? safety::sim::motor(_ports[index]).over_current : PROS_ERR;
+            }
+
+            double get_actual_velocity(const std::uint8_t index = 0) const
+            {
+                if (!present(index))
+                    return PROS_ERR_F;
+                const safety::sim::MotorState &motor = safety::sim::motor(_ports[index]);
+                return motor.millivolts / 1000.0 * motor.rpm_per_volt;
+            }
+
+            std::int32_t move_voltage(const std::int32_t voltage) const
+            {
+                for (std::int8_t port : _ports)
+                    safety::sim::motor(port).millivolts = port < 0 ? -voltage : voltage;
+                return 1;
+            }
+
+        private:
+            static constexpr std::int8_t PROS_ERR_BYTE = INT8_MAX;
+
+            bool present(std::uint8_t index) const
+            {
+                return index < _ports.size() && safety::sim::type(_ports[index] < 0 ? -_ports[index] : _ports[index]) ==
+                                                    DeviceType::motor;
+            }
+
+            std::vector<std::int8_t> _ports;
+        };
+
+        class Controller
+        {
+        public:
+            std::int32_t set_text(std::uint8_t line, std::uint8_t col, const char *str)
+            {
+                safety::sim::State &sim = safety::sim::state();
+                if (line > 2 || col > 18)
+                    return PROS_ERR;
+                std::size_t i = col;
+                for (; str[i - col] && i + 1 < sim.controller_text[line].size(); i++)
+                    sim.controller_text[line][i] = str[i - col];
+                sim.controller_text[line][i] = '\0';
+                sim.controller_messages++;
+                return 1;
+            }
+
+            std::int32_t rumble(const char *)
+            {
+                safety::sim::state().rumbles++;
+                safety::sim::state().controller_messages++;
+                return 1;
+            }
+        };
+    } // namespace v5
+
+    namespace c
+    {
+        inline imu_status_e_t imu_get_status(std::uint8_t port)
+        {
+            if (safety::sim::type(port) != DeviceType::imu)
+                return E_IMU_STATUS_ERROR;
+            return safety::sim::state().imu_status[port];
+        }
+
+        inline std::int32_t imu_reset(std::uint8_t port)
+        {
+            if (safety::sim::type(port) != DeviceType::imu)
+                return PROS_ERR;
+            return 1;
+        }
+
+        inline imu_accel_s_t imu_get_accel(std::uint8_t port)
+        {
+            if (safety::sim::type(port) != DeviceType::imu)
+                return {PROS_ERR_F, PROS_ERR_F, PROS_ERR_F, PROS_ERR_F};
+            return safety::sim::state().imu_accel[port];
+        }
+
+        inline std::uint8_t competition_get_status()
+        {
+            return safety::sim::state().competition_status;
+        }
+
+        inline std::int32_t controller_is_connected(controller_id_e_t id)
+        {
+            return id == E_CONTROLLER_MASTER && safety::sim::state().controller_connected ? 1 : 0;
+        }
+
+        inline adi_port_config_e_t ext_adi_port_get_config(std::uint8_t smart_port, std::uint8_t adi_port)
+        {
+            if (adi_port < 1 || adi_port > 8 || safety::sim::type(smart_port) != DeviceType::adi)
+            {
+                errno = ENODEV;
+                return E_ADI_ERR;
+            }
+            return safety::sim::state().adi_config[smart_port][adi_port - 1];
+        }
+
+        inline std::int32_t motor_get_current_draw(std::int8_t port)
+        {
+            if (safety::sim::type(port < 0 ? -port : port) != DeviceType::motor)
+                return PROS_ERR;
+            return safety::sim::motor(port).current_ma;
+        }
+
+        inline std::int32_t motor_move_voltage(std::int8_t port, std::int32_t voltage)
+        {
+            safety::sim::motor(port).millivolts = port < 0 ? -voltage : voltage;
+            return 1;
+        }
+    } // namespace c
+
+    namespace usd
+    {
+        inline std::int32_t is_installed()
+        {
+            return safety::sim::state().sd_installed ? 1 : 0;
+        }
+    } // namespace usd
+
+    namespace screen
+    {
+        inline std::uint32_t set_pen(std::uint32_t color)
+        {
+            safety::sim::state().screen_pen = color;
+            return 1;
+        }
+
+        inline std::uint32_t set_eraser(std::uint32_t color)
+        {
+            safety::sim::state().screen_eraser = color;
+            return 1;
+        }
+
+        inline std::uint32_t fill_rect(std::int16_t, std::int16_t, std::int16_t, std::int16_t)
+        {
+            safety::sim::state().screen_fills++;
+            return 1;
+        }
+
+        template <typename... Params>
+        std::uint32_t print(text_format_e_t, std::int16_t, std::int16_t, const char *, Params...)
+        {
+            safety::sim::state().screen_prints++;
+            return 1;
+        }
+    } // namespace screen
+} // namespace pros
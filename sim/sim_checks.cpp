@@ -0,0 +1,167 @@
+/**
+ * @file sim_checks.cpp
+ * @brief Host checks that drive the watchdog, debouncer, manifest, and scan tiers through the simulation backend.
+ * @author Adam Salem
+ * @copyright Copyright (c) 2024 Adam Salem
+ *
+ * Build and run it on a computer from the root of the repository:
+ *
+ * @code
+ * g++ -std=gnu++20 -DSAFETY_SIM -I. -o sim_checks sim/sim_checks.cpp
+ * ./sim_checks
+ * @endcode
+ *
+ * Every check starts from `safety::sim::reset`, scripts the ports it needs, and prints PASS or FAIL. The program
+ * exits with a non-zero status if any check failed, so it can run as a CI step.
+ */
+
+#include <cstdint>
+#include <cstdio>
+
+#ifndef SAFETY_SIM
+#define SAFETY_SIM
+#endif
+#include "safety.h"
+
+namespace
+{
+    using pros::v5::DeviceType;
+
+    int failures = 0;
+
+    /**
+     * Prints the outcome of a check and counts it if it failed.
+     *
+     * @param name The name printed for the check.
+     * @param ok Whether the check passed.
+     */
+    void report(const char *name, bool ok)
+    {
+        std::printf("%s %s\n", ok ? "PASS" : "FAIL", name);
+        if (!ok)
+            failures++;
+    }
+
+    /**
+     * Samples the watchdog every period until the simulated clock reaches a time, counting the queued events.
+     *
+     * @param watchdog The watchdog to drive. It must have been started to take its baseline.
+     * @param until_ms The simulated time to stop at.
+     * @param last Receives the last event taken, if any.
+     *
+     * @return The number of events taken.
+     */
+    int runUntil(safety::Watchdog &watchdog, std::uint32_t until_ms, safety::PortEvent &last)
+    {
+        int events = 0;
+        while (safety::sim::millis() < until_ms)
+        {
+            watchdog.sample();
+            safety::PortEvent event;
+            while (watchdog.poll(event))
+            {
+                last = event;
+                events++;
+            }
+            safety::sim::advance(watchdog.period());
+        }
+        return events;
+    }
+
+    /**
+     * A cable that drops out for less than the debounce window is not reported, but a real unplug is, once.
+     */
+    void debounceRejectsGlitch()
+    {
+        safety::sim::reset();
+        for (int port = 1; port <= 4; port++)
+            safety::sim::setType(port, DeviceType::motor);
+
+        safety::Watchdog watchdog(10, safety::DebounceConfig{3, 0});
+        watchdog.start();
+        safety::sim::scheduleGlitch(105, 2, DeviceType::none, DeviceType::motor, 15);
+        safety::PortEvent last{};
+        int glitch_events = runUntil(watchdog, 300, last);
+
+        safety::sim::schedule(305, 3, DeviceType::none);
+        int unplug_events = runUntil(watchdog, 500, last);
+        watchdog.stop();
+
+        report("debounce rejects a 15 ms glitch", glitch_events == 0);
+        report("debounce reports a real unplug once", unplug_events == 1 && last.port == 3 &&
+                                                          last.kind == safety::PortEventKind::unplugged &&
+                                                          last.previous == DeviceType::motor);
+    }
+
+    /**
+     * A manifest diff sorts missing, wrong, and unexpected devices into their own masks.
+     */
+    void manifestDiff()
+    {
+        safety::sim::reset();
+        safety::sim::setType(1, DeviceType::motor);
+        safety::sim::setType(10, DeviceType::distance);
+        safety::sim::setType(5, DeviceType::rotation);
+
+        safety::Manifest robot{{1, DeviceType::motor}, {2, DeviceType::motor}, {10, DeviceType::imu}};
+        safety::ManifestDiff diff;
+        robot.diff(safety::PortSnapshot::capture(), diff);
+
+        report("manifest diff finds the missing motor", diff.missing == safety::PortMask{2});
+        report("manifest diff finds the wrong device", diff.wrongType == safety::PortMask{10});
+        report("manifest diff finds the unexpected device", diff.unexpected == safety::PortMask{5});
+        report("manifest diff is not ok", !diff.ok());
+    }
+
+    /**
+     * A tier 0 port is read on every sample and a tier 2 port once every four, and an unplug on the slower port is
+     * still seen within its interval.
+     */
+    void scanTierCadence()
+    {
+        safety::sim::reset();
+        safety::sim::setType(1, DeviceType::motor);
+        safety::sim::setType(2, DeviceType::motor);
+
+        safety::Manifest robot{{1, DeviceType::motor, 0}, {2, DeviceType::motor, 2}};
+        safety::ScanSchedule schedule = robot.schedule();
+        safety::Watchdog watchdog(10);
+        watchdog.setSchedule(schedule);
+        watchdog.start();
+
+        // Over one full cycle: port 1 every sample, port 2 every 4th, and the 19 unregistered ports, in the lowest
+        // tier, once each.
+        std::uint64_t before = safety::sim::typeReads();
+        for (std::size_t tick = 0; tick < safety::ScanSchedule::CYCLE; tick++)
+        {
+            watchdog.sample();
+            safety::sim::advance(10);
+        }
+        std::uint64_t reads = safety::sim::typeReads() - before;
+        std::uint64_t expected = safety::ScanSchedule::CYCLE + safety::ScanSchedule::CYCLE / schedule.interval(2) +
+                                 (safety::SMART_PORT_COUNT - 2);
+        report("scan tiers read each port at its cadence", reads == expected);
+
+        safety::sim::setType(2, DeviceType::none);
+        bool seen = false;
+        for (std::uint32_t tick = 0; tick < schedule.interval(2) && !seen; tick++)
+        {
+            watchdog.sample();
+            safety::PortEvent event;
+            while (watchdog.poll(event))
+                seen = seen || event.port == 2;
+            safety::sim::advance(10);
+        }
+        watchdog.stop();
+        report("scan tiers see a tier 2 unplug within its interval", seen);
+    }
+} // namespace
+
+int main()
+{
+    debounceRejectsGlitch();
+    manifestDiff();
+    scanTierCadence();
+    std::printf("%d check(s) failed\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file decode_events.cpp
+ * @brief Host-side decoder that turns a safety::EventLog file into CSV.
+ * @author Adam Salem
+ * @copyright Copyright (c) 2024 Adam Salem
+ *
+ * Build with any C++17 compiler, for example `g++ -std=c++17 -O2 -o decode_events tools/decode_events.cpp`,
+ * then run `decode_events safety_events.bin > events.csv`. With no file argument the log is read from stdin.
+ */
+
+#include <cstdint>
+#include <cstdio>
+
+namespace
+{
+    /**
+     * The size of one record in the log, matching `safety::EventRecord`.
+     */
+    constexpr std::size_t RECORD_SIZE = 8;
+
+    /**
+     * The port number of session marker records, matching `safety::EVENT_LOG_SESSION_PORT`.
+     */
+    constexpr std::uint8_t SESSION_PORT = 0;
+
+    /**
+     * Converts a `pros::v5::DeviceType` value to the same name `safety::deviceType_to_string` uses.
+     *
+     * @param type The numeric device type from the log.
+     *
+     * @return The name of the device type, or "unknown".
+     */
+    const char *deviceTypeName(std::uint8_t type)
+    {
+        switch (type)
+        {
+        case 0:
+            return "none";
+        case 2:
+            return "motor";
+        case 4:
+            return "rotation";
+        case 6:
+            return "imu";
+        case 7:
+            return "distance";
+        case 8:
+            return "radio";
+        case 11:
+            return "vision";
+        case 12:
+            return "adi";
+        case 16:
+            return "optical";
+        case 20:
+            return "gps";
+        case 129:
+            return "serial";
+        case 255:
+            return "undefined";
+        default:
+            return "unknown";
+        }
+    }
+
+    /**
+     * Converts a `safety::PortEventKind` value to its name.
+     *
+     * @param kind The numeric event kind from the log.
+     *
+     * @return The name of the event kind, or "unknown".
+     */
+    const char *eventKindName(std::uint8_t kind)
+    {
+        switch (kind)
+        {
+        case 0:
+            return "plugged";
+        case 1:
+            return "unplugged";
+        case 2:
+            return "changed";
+        default:
+            return "unknown";
+        }
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::FILE *in = stdin;
+    if (argc > 1)
+    {
+        in = std::fopen(argv[1], "rb");
+        if (!in)
+        {
+            std::fprintf(stderr, "decode_events: cannot open %s\n", argv[1]);
+            return 1;
+        }
+    }
+
+    std::printf("session,session_start_ms,time_ms,port,event,previous,current\n");
+    unsigned char record[RECORD_SIZE];
+    long session = -1;
+    std::uint32_t session_start = 0;
+    while (std::fread(record, 1, RECORD_SIZE, in) == RECORD_SIZE)
+    {
+        std::uint32_t time = std::uint32_t(record[0]) | std::uint32_t(record[1]) << 8 |
+                             std::uint32_t(record[2]) << 16 | std::uint32_t(record[3]) << 24;
+        std::uint8_t port = record[4];
+        if (port == SESSION_PORT)
+        {
+            session++;
+            session_start = time;
+            continue;
+        }
+        std::printf("%ld,%lu,%lu,%u,%s,%s,%s\n", session, static_cast<unsigned long>(session_start),
+                    static_cast<unsigned long>(time), static_cast<unsigned>(port), eventKindName(record[5]),
+                    deviceTypeName(record[6]), deviceTypeName(record[7]));
+    }
+
+    if (in != stdin)
+        std::fclose(in);
+    return 0;
+}